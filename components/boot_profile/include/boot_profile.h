@@ -0,0 +1,53 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Boot timeline. Each mark records the time a bring-up step finished. The
+ * times come from esp_timer_get_time(), on targets with a SYSTIMER it counts
+ * from chip reset, so the first mark also covers ROM and bootloader.
+ *
+ * The marks live in RTC memory. If the previous boot did not get to
+ * boot_profile_done(), e.g. because it crashed or was reset, its timeline
+ * is printed by boot_profile_init().
+ */
+
+#if CONFIG_BOOT_PROFILE
+
+// First call in app_main(), prints a leftover timeline and starts a new one
+void boot_profile_init(void);
+
+// Name is copied, safe from ISRs
+void boot_profile_mark(const char *name);
+
+// Mark name, print the waterfall and close the timeline. Later calls and
+// marks are ignored.
+void boot_profile_done(const char *name);
+
+// Print the waterfall of the current timeline
+void boot_profile_dump(void);
+
+#else
+
+static inline void boot_profile_init(void) {}
+static inline void boot_profile_mark(const char *name) { (void)name; }
+static inline void boot_profile_done(const char *name) { (void)name; }
+static inline void boot_profile_dump(void) {}
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#include "boot_profile.h"
+
+#if CONFIG_BOOT_PROFILE
+
+#define BOOT_PROFILE_MAGIC 0xB0070F11
+#define BOOT_PROFILE_NAME_LEN 16
+#define BOOT_PROFILE_BAR_WIDTH 40
+
+
+static const char *TAG = "boot_profile";
+
+
+typedef struct {
+    int64_t us;
+    char name[BOOT_PROFILE_NAME_LEN];
+} boot_mark_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    bool done;
+    boot_mark_t marks[CONFIG_BOOT_PROFILE_MAX_MARKS];
+} boot_timeline_t;
+
+// Not cleared on reset, only on power-up is its content random
+static RTC_NOINIT_ATTR boot_timeline_t timeline;
+static portMUX_TYPE timeline_lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+static void print_timeline(const boot_timeline_t *t)
+{
+    uint32_t count = t->count < CONFIG_BOOT_PROFILE_MAX_MARKS ? t->count : CONFIG_BOOT_PROFILE_MAX_MARKS;
+    if (!count) {
+        return;
+    }
+    int64_t total = t->marks[count - 1].us;
+    if (total <= 0) {
+        total = 1;
+    }
+
+    char bar[BOOT_PROFILE_BAR_WIDTH + 1];
+    int64_t prev = 0;
+    ESP_LOGI(TAG, "%9s %9s  %-*s", "at ms", "step ms", BOOT_PROFILE_NAME_LEN, "step");
+    for (uint32_t i = 0; i < count; i++) {
+        const boot_mark_t *m = &t->marks[i];
+        int from = prev * BOOT_PROFILE_BAR_WIDTH / total;
+        int to = m->us * BOOT_PROFILE_BAR_WIDTH / total;
+        if (to <= from) {
+            to = from + 1;
+        }
+        if (to > BOOT_PROFILE_BAR_WIDTH) {
+            to = BOOT_PROFILE_BAR_WIDTH;
+        }
+        memset(bar, ' ', from);
+        memset(bar + from, '#', to - from);
+        bar[to] = '\0';
+        ESP_LOGI(TAG, "%9.1f %9.1f  %-*.*s|%s", m->us / 1000.0, (m->us - prev) / 1000.0,
+                 BOOT_PROFILE_NAME_LEN, BOOT_PROFILE_NAME_LEN, m->name, bar);
+        prev = m->us;
+    }
+}
+
+void boot_profile_init(void)
+{
+    if (timeline.magic == BOOT_PROFILE_MAGIC && !timeline.done && timeline.count) {
+        ESP_LOGW(TAG, "Previous boot did not complete, its timeline:");
+        print_timeline(&timeline);
+    }
+    portENTER_CRITICAL(&timeline_lock);
+    timeline.magic = BOOT_PROFILE_MAGIC;
+    timeline.count = 0;
+    timeline.done = false;
+    portEXIT_CRITICAL(&timeline_lock);
+    boot_profile_mark("app_main");
+}
+
+void IRAM_ATTR boot_profile_mark(const char *name)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_SAFE(&timeline_lock);
+    if (timeline.magic == BOOT_PROFILE_MAGIC && !timeline.done &&
+            timeline.count < CONFIG_BOOT_PROFILE_MAX_MARKS) {
+        boot_mark_t *m = &timeline.marks[timeline.count++];
+        m->us = now;
+        // No strncpy(), it may live in flash
+        int i = 0;
+        for (; i < BOOT_PROFILE_NAME_LEN - 1 && name[i]; i++) {
+            m->name[i] = name[i];
+        }
+        m->name[i] = '\0';
+    }
+    portEXIT_CRITICAL_SAFE(&timeline_lock);
+}
+
+void boot_profile_done(const char *name)
+{
+    if (timeline.done) {
+        return;
+    }
+    boot_profile_mark(name);
+    portENTER_CRITICAL(&timeline_lock);
+    timeline.done = true;
+    portEXIT_CRITICAL(&timeline_lock);
+    boot_profile_dump();
+}
+
+void boot_profile_dump(void)
+{
+    boot_timeline_t copy;
+
+    portENTER_CRITICAL(&timeline_lock);
+    memcpy(&copy, &timeline, sizeof(copy));
+    portEXIT_CRITICAL(&timeline_lock);
+    print_timeline(&copy);
+}
+
+#endif // CONFIG_BOOT_PROFILE
@@ -54,6 +54,13 @@ typedef struct {
     uint8_t colmod_val;    // save current value of LCD_CMD_COLMOD register
     uint8_t ramctl_val_1;
     uint8_t ramctl_val_2;
+    // shadow of the address window last sent with CASET/RASET, end exclusive
+    int win_x_start;
+    int win_x_end;
+    int win_y_start;
+    int win_y_end;
+    bool win_valid;
+    uint32_t elided_cmds;
 } st7735_panel_t;
 
 esp_err_t
@@ -157,6 +164,7 @@ static esp_err_t panel_st7735_reset(esp_lcd_panel_t *panel)
 {
     st7735_panel_t *st7735 = __containerof(panel, st7735_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7735->io;
+    st7735->win_valid = false;
 
     // perform hardware reset
     if (st7735->reset_gpio_num >= 0) {
@@ -177,6 +185,7 @@ static esp_err_t panel_st7735_init(esp_lcd_panel_t *panel)
 {
     st7735_panel_t *st7735 = __containerof(panel, st7735_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7735->io;
+    st7735->win_valid = false;
     // LCD goes into sleep mode and display will be turned off after power on reset, exit sleep mode first
     ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPOUT, NULL, 0), TAG,
                         "io tx param failed");
@@ -206,19 +215,34 @@ static esp_err_t panel_st7735_draw_bitmap(esp_lcd_panel_t *panel, int x_start, i
     y_start += st7735->y_gap;
     y_end += st7735->y_gap;
 
-    // define an area of frame memory where MCU can access
-    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, (uint8_t[]) {
-        (x_start >> 8) & 0xFF,
-        x_start & 0xFF,
-        ((x_end - 1) >> 8) & 0xFF,
-        (x_end - 1) & 0xFF,
-    }, 4), TAG, "io tx param failed");
-    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, (uint8_t[]) {
-        (y_start >> 8) & 0xFF,
-        y_start & 0xFF,
-        ((y_end - 1) >> 8) & 0xFF,
-        (y_end - 1) & 0xFF,
-    }, 4), TAG, "io tx param failed");
+    // define an area of frame memory where MCU can access, skip what the panel already has
+    bool win_valid = st7735->win_valid;
+    st7735->win_valid = false;
+    if (win_valid && st7735->win_x_start == x_start && st7735->win_x_end == x_end) {
+        st7735->elided_cmds++;
+    } else {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, (uint8_t[]) {
+            (x_start >> 8) & 0xFF,
+            x_start & 0xFF,
+            ((x_end - 1) >> 8) & 0xFF,
+            (x_end - 1) & 0xFF,
+        }, 4), TAG, "io tx param failed");
+        st7735->win_x_start = x_start;
+        st7735->win_x_end = x_end;
+    }
+    if (win_valid && st7735->win_y_start == y_start && st7735->win_y_end == y_end) {
+        st7735->elided_cmds++;
+    } else {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, (uint8_t[]) {
+            (y_start >> 8) & 0xFF,
+            y_start & 0xFF,
+            ((y_end - 1) >> 8) & 0xFF,
+            (y_end - 1) & 0xFF,
+        }, 4), TAG, "io tx param failed");
+        st7735->win_y_start = y_start;
+        st7735->win_y_end = y_end;
+    }
+    st7735->win_valid = true;
     // transfer frame buffer
     size_t len = (x_end - x_start) * (y_end - y_start) * st7735->fb_bits_per_pixel / 8;
     ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, color_data, len), TAG, "io tx color failed");
@@ -226,6 +250,14 @@ static esp_err_t panel_st7735_draw_bitmap(esp_lcd_panel_t *panel, int x_start, i
     return ESP_OK;
 }
 
+esp_err_t esp_lcd_panel_st7735_get_elided_cmds(esp_lcd_panel_handle_t panel, uint32_t *count)
+{
+    ESP_RETURN_ON_FALSE(panel && count, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7735_panel_t *st7735 = __containerof(panel, st7735_panel_t, base);
+    *count = st7735->elided_cmds;
+    return ESP_OK;
+}
+
 static esp_err_t panel_st7735_invert_color(esp_lcd_panel_t *panel, bool invert_color_data)
 {
     st7735_panel_t *st7735 = __containerof(panel, st7735_panel_t, base);
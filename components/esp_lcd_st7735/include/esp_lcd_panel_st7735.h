@@ -26,6 +26,20 @@ extern "C" {
  */
 esp_err_t esp_lcd_new_panel_st7735(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel);
 
+/**
+ * @brief Get the number of CASET/RASET commands skipped by draw_bitmap
+ *
+ * The panel keeps a shadow of its address window and only resends the parts
+ * of it that change between two bitmaps.
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7735()
+ * @param[out] count Number of commands not sent
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_st7735_get_elided_cmds(esp_lcd_panel_handle_t panel, uint32_t *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,88 @@
+#ifndef I2C_SCHED_H
+#define I2C_SCHED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * One task owns the I2C bus and serves requests one at a time, the highest
+ * priority first. Callers block until their request is done, but never
+ * longer than its deadline plus the transaction that is on the bus when it
+ * is queued: a request whose deadline passes while it waits fails with
+ * ESP_ERR_TIMEOUT without touching the bus, and a transfer only gets the
+ * time left until its deadline.
+ *
+ * A transfer that times out leaves the bus reset, which clocks a slave
+ * holding SDA low out of its byte.
+ */
+
+typedef enum {
+    I2C_SCHED_PRIO_TOUCH,       // served first
+    I2C_SCHED_PRIO_PMU,         // power management and telemetry
+    I2C_SCHED_PRIO_DIAG,        // scans, probes, anything that can wait
+    I2C_SCHED_PRIO_MAX,
+} i2c_sched_prio_t;
+
+// Runs in the scheduler task with the bus to itself
+typedef esp_err_t (*i2c_sched_fn_t)(void *arg);
+
+typedef struct {
+    uint32_t requests;          // served, expired ones included
+    uint32_t expired;           // deadline passed before the bus was free
+    uint32_t errors;            // failed on the bus
+    uint32_t rejected;          // queue was full
+    uint32_t wait_max_us;       // longest time queued
+    uint64_t wait_total_us;
+} i2c_sched_prio_stats_t;
+
+typedef struct {
+    i2c_sched_prio_stats_t prio[I2C_SCHED_PRIO_MAX];
+    uint64_t busy_us;           // bus in use
+    uint64_t window_us;         // time the counters cover
+    uint32_t bus_resets;
+} i2c_sched_stats_t;
+
+esp_err_t i2c_sched_init(i2c_master_bus_handle_t bus);
+
+/**
+ * @brief Write tx, then read rx with a repeated start
+ *
+ * Either length may be 0 for a plain read or write.
+ *
+ * @return ESP_ERR_TIMEOUT when the deadline passed, ESP_ERR_NO_MEM when the
+ *         queue of the priority is full, or the result of the transfer
+ */
+esp_err_t i2c_sched_transfer(i2c_master_dev_handle_t dev, i2c_sched_prio_t prio,
+                             const uint8_t *tx, size_t tx_len,
+                             uint8_t *rx, size_t rx_len, uint32_t deadline_ms);
+
+/**
+ * @brief Run fn(arg) in the scheduler task, for drivers that access the bus
+ *        themselves
+ *
+ * The deadline only decides whether fn starts, its bus accesses are bounded
+ * by the timeouts of the driver.
+ */
+esp_err_t i2c_sched_run(i2c_sched_prio_t prio, i2c_sched_fn_t fn, void *arg, uint32_t deadline_ms);
+
+// Counters since the last reset
+void i2c_sched_get_stats(i2c_sched_stats_t *stats, bool reset);
+
+void i2c_sched_dump(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,259 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "i2c_sched.h"
+
+
+#define I2C_SCHED_STACK_SIZE    (4 * 1024)
+
+
+static const char *TAG = "i2c_sched";
+
+
+// Lives on the stack of the caller, which waits for done
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    i2c_sched_fn_t fn;
+    void *arg;
+    int64_t queued_us;
+    int64_t deadline_us;
+    esp_err_t result;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+} i2c_request_t;
+
+static i2c_master_bus_handle_t bus_handle;
+static QueueHandle_t queues[I2C_SCHED_PRIO_MAX];
+static TaskHandle_t sched_task;
+
+// Written by the scheduler task only, apart from rejected
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static i2c_sched_stats_t stats;
+static int64_t window_start_us;
+
+
+static esp_err_t execute(i2c_request_t *req)
+{
+    if (req->fn) {
+        return req->fn(req->arg);
+    }
+
+    // The transfer gets what is left until the deadline, at least 1 ms
+    int timeout_ms = (int)((req->deadline_us - esp_timer_get_time()) / 1000);
+    if (timeout_ms < 1) {
+        timeout_ms = 1;
+    }
+    if (req->tx_len && req->rx_len) {
+        return i2c_master_transmit_receive(req->dev, req->tx, req->tx_len, req->rx, req->rx_len, timeout_ms);
+    } else if (req->rx_len) {
+        return i2c_master_receive(req->dev, req->rx, req->rx_len, timeout_ms);
+    }
+    return i2c_master_transmit(req->dev, req->tx, req->tx_len, timeout_ms);
+}
+
+static i2c_request_t *next_request(i2c_sched_prio_t *prio)
+{
+    i2c_request_t *req;
+    for (int i = 0; i < I2C_SCHED_PRIO_MAX; i++) {
+        if (xQueueReceive(queues[i], &req, 0) == pdTRUE) {
+            *prio = (i2c_sched_prio_t)i;
+            return req;
+        }
+    }
+    return NULL;
+}
+
+static void serve(i2c_request_t *req, i2c_sched_prio_t prio)
+{
+    int64_t start = esp_timer_get_time();
+    uint32_t waited = (uint32_t)(start - req->queued_us);
+    bool expired = start > req->deadline_us;
+    bool reset = false;
+
+    if (expired) {
+        req->result = ESP_ERR_TIMEOUT;
+    } else {
+        req->result = execute(req);
+        // A slave holding SDA low makes every following transfer time out
+        if (req->result == ESP_ERR_TIMEOUT && !req->fn) {
+            reset = i2c_master_bus_reset(bus_handle) == ESP_OK;
+        }
+    }
+    int64_t busy = esp_timer_get_time() - start;
+
+    portENTER_CRITICAL(&stats_lock);
+    i2c_sched_prio_stats_t *s = &stats.prio[prio];
+    s->requests++;
+    s->wait_total_us += waited;
+    if (waited > s->wait_max_us) {
+        s->wait_max_us = waited;
+    }
+    if (expired) {
+        s->expired++;
+    } else {
+        stats.busy_us += busy;
+        if (req->result != ESP_OK) {
+            s->errors++;
+        }
+    }
+    if (reset) {
+        stats.bus_resets++;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (reset) {
+        ESP_LOGW(TAG, "transfer timed out, bus reset");
+    }
+    xSemaphoreGive(req->done);
+}
+
+static void sched_task_fn(void *arg)
+{
+    while (1) {
+        // One notification per queued request
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        i2c_sched_prio_t prio;
+        i2c_request_t *req = next_request(&prio);
+        if (req) {
+            serve(req, prio);
+        }
+    }
+}
+
+static esp_err_t submit(i2c_request_t *req, i2c_sched_prio_t prio, uint32_t deadline_ms)
+{
+    if (!sched_task || prio >= I2C_SCHED_PRIO_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    req->queued_us = esp_timer_get_time();
+    req->deadline_us = req->queued_us + (int64_t)deadline_ms * 1000;
+
+    // Requests made from within i2c_sched_run() already own the bus
+    if (xTaskGetCurrentTaskHandle() == sched_task) {
+        return execute(req);
+    }
+
+    req->done = xSemaphoreCreateBinaryStatic(&req->done_buf);
+    if (xQueueSend(queues[prio], &req, 0) != pdTRUE) {
+        portENTER_CRITICAL(&stats_lock);
+        stats.prio[prio].rejected++;
+        portEXIT_CRITICAL(&stats_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    xTaskNotifyGive(sched_task);
+    // Bounded by the deadline, the scheduler fails the request rather
+    // than letting it wait longer
+    xSemaphoreTake(req->done, portMAX_DELAY);
+    return req->result;
+}
+
+esp_err_t i2c_sched_transfer(i2c_master_dev_handle_t dev, i2c_sched_prio_t prio,
+                             const uint8_t *tx, size_t tx_len,
+                             uint8_t *rx, size_t rx_len, uint32_t deadline_ms)
+{
+    i2c_request_t req = {
+        .dev = dev,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .rx_len = rx_len,
+    };
+    return submit(&req, prio, deadline_ms);
+}
+
+esp_err_t i2c_sched_run(i2c_sched_prio_t prio, i2c_sched_fn_t fn, void *arg, uint32_t deadline_ms)
+{
+    i2c_request_t req = {
+        .fn = fn,
+        .arg = arg,
+    };
+    return submit(&req, prio, deadline_ms);
+}
+
+void i2c_sched_get_stats(i2c_sched_stats_t *out, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    out->window_us = now - window_start_us;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+        window_start_us = now;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void i2c_sched_dump(void)
+{
+    static const char *const names[I2C_SCHED_PRIO_MAX] = {
+        "touch", "pmu", "diag"
+    };
+
+    i2c_sched_stats_t s;
+    i2c_sched_get_stats(&s, true);
+    uint32_t load = s.window_us ? (uint32_t)(s.busy_us * 1000 / s.window_us) : 0;
+    ESP_LOGI(TAG, "bus %lu.%lu%% busy, %lu resets", (unsigned long)(load / 10),
+             (unsigned long)(load % 10), (unsigned long)s.bus_resets);
+    for (int i = 0; i < I2C_SCHED_PRIO_MAX; i++) {
+        const i2c_sched_prio_stats_t *p = &s.prio[i];
+        if (!p->requests && !p->rejected) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-5s %lu req, wait avg %lu max %lu us, %lu expired, %lu errors, %lu rejected",
+                 names[i], (unsigned long)p->requests,
+                 (unsigned long)(p->requests ? p->wait_total_us / p->requests : 0),
+                 (unsigned long)p->wait_max_us, (unsigned long)p->expired,
+                 (unsigned long)p->errors, (unsigned long)p->rejected);
+    }
+}
+
+#if CONFIG_I2C_SCHED_STATS_INTERVAL > 0
+static void stats_timer_cb(void *arg)
+{
+    i2c_sched_dump();
+}
+#endif
+
+esp_err_t i2c_sched_init(i2c_master_bus_handle_t bus)
+{
+    if (sched_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bus_handle = bus;
+    for (int i = 0; i < I2C_SCHED_PRIO_MAX; i++) {
+        queues[i] = xQueueCreate(CONFIG_I2C_SCHED_QUEUE_LENGTH, sizeof(i2c_request_t *));
+        if (!queues[i]) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    window_start_us = esp_timer_get_time();
+    if (xTaskCreate(sched_task_fn, "i2c_sched", I2C_SCHED_STACK_SIZE, NULL,
+                    CONFIG_I2C_SCHED_TASK_PRIORITY, &sched_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+#if CONFIG_I2C_SCHED_STATS_INTERVAL > 0
+    const esp_timer_create_args_t args = {
+        .callback = &stats_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "i2c_stats",
+        .skip_unhandled_events = true
+    };
+    esp_timer_handle_t timer = NULL;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_I2C_SCHED_STATS_INTERVAL * 1000000ULL));
+#endif
+    return ESP_OK;
+}
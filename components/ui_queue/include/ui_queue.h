@@ -0,0 +1,49 @@
+#ifndef UI_QUEUE_H
+#define UI_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Lock-free queue of LVGL updates. Any task may post, only the LVGL task
+ * drains the queue and applies the updates, so producers never wait for
+ * the LVGL mutex. Posting fails (and returns false) when the queue is full.
+ *
+ * Objects passed in must stay alive until the update has been applied.
+ */
+
+typedef void (*ui_queue_call_t)(void *arg);
+
+bool ui_queue_set_label_text(lv_obj_t *label, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+bool ui_queue_show_screen(lv_obj_t *screen, lv_scr_load_anim_t anim, uint32_t time);
+
+// Add a label with the given text as last child of parent
+bool ui_queue_append_row(lv_obj_t *parent, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Run fn(arg) in the LVGL task, e.g. to build a screen
+bool ui_queue_call(ui_queue_call_t fn, void *arg);
+
+// Called after every post, e.g. to wake up the LVGL task
+void ui_queue_set_notify(void (*notify)(void));
+
+// Apply up to max queued updates, LVGL task only. Returns the number applied.
+uint32_t ui_queue_drain(uint32_t max);
+
+// Updates lost because the queue was full
+uint32_t ui_queue_dropped(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
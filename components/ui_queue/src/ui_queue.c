@@ -0,0 +1,203 @@
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "ui_queue.h"
+
+
+#define UI_QUEUE_LENGTH CONFIG_UI_QUEUE_LENGTH
+#define UI_QUEUE_MASK (UI_QUEUE_LENGTH - 1)
+#define UI_QUEUE_TEXT_LEN CONFIG_UI_QUEUE_TEXT_LEN
+
+_Static_assert((UI_QUEUE_LENGTH & UI_QUEUE_MASK) == 0, "CONFIG_UI_QUEUE_LENGTH must be a power of two");
+
+
+static const char *TAG = "ui_queue";
+
+
+typedef enum {
+    UI_CMD_SET_LABEL_TEXT,
+    UI_CMD_SHOW_SCREEN,
+    UI_CMD_APPEND_ROW,
+    UI_CMD_CALL,
+} ui_cmd_type_t;
+
+typedef struct {
+    ui_cmd_type_t type;
+    lv_obj_t *obj;
+    union {
+        char text[UI_QUEUE_TEXT_LEN];
+        struct {
+            lv_scr_load_anim_t anim;
+            uint32_t time;
+        } screen;
+        struct {
+            ui_queue_call_t fn;
+            void *arg;
+        } call;
+    };
+} ui_cmd_t;
+
+/*
+ * Bounded MPSC ring after Dmitry Vyukov. Each slot carries a sequence
+ * number telling whose turn it is: producers claim position pos when the
+ * sequence equals pos, publish by setting it to pos + 1, and the consumer
+ * hands the slot back for the next lap with pos + UI_QUEUE_LENGTH.
+ *
+ * Sequences are stored relative to the slot index, so the zero-initialised
+ * array already is an empty queue and no init call is needed.
+ */
+typedef struct {
+    atomic_uint sequence;
+    ui_cmd_t cmd;
+} ui_slot_t;
+
+static ui_slot_t slots[UI_QUEUE_LENGTH];
+static atomic_uint enqueue_pos;
+static uint32_t dequeue_pos;
+static atomic_uint dropped;
+static void (*notify_cb)(void);
+
+
+static ui_slot_t *claim(uint32_t *claimed) {
+    uint32_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        ui_slot_t *slot = &slots[pos & UI_QUEUE_MASK];
+        uint32_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire) + (pos & UI_QUEUE_MASK);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                *claimed = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            ESP_LOGW(TAG, "queue full, update dropped");
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+
+static bool publish(ui_slot_t *slot, uint32_t pos) {
+    atomic_store_explicit(&slot->sequence, pos + 1 - (pos & UI_QUEUE_MASK), memory_order_release);
+    if (notify_cb) {
+        notify_cb();
+    }
+    return true;
+}
+
+
+static bool post_text(ui_cmd_type_t type, lv_obj_t *obj, const char *fmt, va_list args) {
+    uint32_t pos;
+    ui_slot_t *slot = claim(&pos);
+    if (!slot) {
+        return false;
+    }
+    slot->cmd.type = type;
+    slot->cmd.obj = obj;
+    vsnprintf(slot->cmd.text, sizeof(slot->cmd.text), fmt, args);
+    return publish(slot, pos);
+}
+
+
+bool ui_queue_set_label_text(lv_obj_t *label, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool ret = post_text(UI_CMD_SET_LABEL_TEXT, label, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+
+bool ui_queue_append_row(lv_obj_t *parent, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool ret = post_text(UI_CMD_APPEND_ROW, parent, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+
+bool ui_queue_show_screen(lv_obj_t *screen, lv_scr_load_anim_t anim, uint32_t time) {
+    uint32_t pos;
+    ui_slot_t *slot = claim(&pos);
+    if (!slot) {
+        return false;
+    }
+    slot->cmd.type = UI_CMD_SHOW_SCREEN;
+    slot->cmd.obj = screen;
+    slot->cmd.screen.anim = anim;
+    slot->cmd.screen.time = time;
+    return publish(slot, pos);
+}
+
+
+bool ui_queue_call(ui_queue_call_t fn, void *arg) {
+    uint32_t pos;
+    ui_slot_t *slot = claim(&pos);
+    if (!slot) {
+        return false;
+    }
+    slot->cmd.type = UI_CMD_CALL;
+    slot->cmd.obj = NULL;
+    slot->cmd.call.fn = fn;
+    slot->cmd.call.arg = arg;
+    return publish(slot, pos);
+}
+
+
+void ui_queue_set_notify(void (*notify)(void)) {
+    notify_cb = notify;
+}
+
+
+static void apply(const ui_cmd_t *cmd) {
+    switch (cmd->type) {
+        case UI_CMD_SET_LABEL_TEXT:
+            lv_label_set_text(cmd->obj, cmd->text);
+            break;
+        case UI_CMD_SHOW_SCREEN:
+            lv_scr_load_anim(cmd->obj, cmd->screen.anim, cmd->screen.time, 0, false);
+            break;
+        case UI_CMD_APPEND_ROW: {
+            lv_obj_t *row = lv_label_create(cmd->obj);
+            lv_label_set_text(row, cmd->text);
+            break;
+        }
+        case UI_CMD_CALL:
+            cmd->call.fn(cmd->call.arg);
+            break;
+    }
+}
+
+
+uint32_t ui_queue_drain(uint32_t max) {
+    uint32_t count = 0;
+
+    while (count < max) {
+        ui_slot_t *slot = &slots[dequeue_pos & UI_QUEUE_MASK];
+        uint32_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire) + (dequeue_pos & UI_QUEUE_MASK);
+        if ((int32_t)(seq - (dequeue_pos + 1)) < 0) {
+            break;
+        }
+        apply(&slot->cmd);
+        atomic_store_explicit(&slot->sequence,
+            dequeue_pos + UI_QUEUE_LENGTH - (dequeue_pos & UI_QUEUE_MASK), memory_order_release);
+        dequeue_pos++;
+        count++;
+    }
+    return count;
+}
+
+
+uint32_t ui_queue_dropped(void) {
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
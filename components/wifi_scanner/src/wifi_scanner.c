@@ -7,6 +7,8 @@
 #include "lvgl.h"
 #include "nvs_flash.h"
 #include "regex.h"
+#include "boot_profile.h"
+#include "ui_queue.h"
 
 #include "wifi_scanner.h"
 
@@ -48,6 +50,7 @@ static void init_wifi(void) {
 }
 
 
+static lv_obj_t *scan_status = NULL;
 static SemaphoreHandle_t background_scan_semaphore = NULL;
 static SemaphoreHandle_t scan_data_semaphore = NULL;
 static wifi_ap_record_t ap_info[DEFAULT_SCAN_LIST_SIZE] = {0, };
@@ -65,6 +68,7 @@ static void scan_networks(void *parameters) {
         xSemaphoreTake(background_scan_semaphore, portMAX_DELAY);
 
         ESP_LOGI(TAG, "WiFi background scan started");
+        ui_queue_set_label_text(scan_status, "Scanning ...");
 
         ap_count = 0;
         ap_info_index = 0;
@@ -101,6 +105,9 @@ static void scan_networks(void *parameters) {
         }
 
         ESP_LOGI(TAG, "WiFi background scan done");
+        ui_queue_set_label_text(scan_status, "Found %" PRIu16 " networks", ap_count);
+        // Only the first scan ends the boot timeline
+        boot_profile_done("first scan");
 
         xSemaphoreGive(scan_data_semaphore);
     }
@@ -195,6 +202,12 @@ static void cycle_timer_cb(lv_timer_t *timer) {
     lv_obj_t *current_screen = lv_scr_act();
     lv_obj_t *new_screen = NULL;
 
+    // The scan results belong to the scan task until it is done, check for
+    // that instead of blocking the LVGL task.
+    if (current_screen == main_screen.screen && xSemaphoreTake(scan_data_semaphore, 0) != pdTRUE) {
+        return;
+    }
+
     if (ap_info_index < ap_info_length) {
         const wifi_ap_record_t *info = &ap_info[ap_info_index];
         details_screen_t *new_details = NULL;
@@ -227,13 +240,12 @@ static void cycle_timer_cb(lv_timer_t *timer) {
         new_screen = main_screen.screen;
     }
 
-    if (current_screen == main_screen.screen && new_screen != main_screen.screen) {
-        xSemaphoreTake(scan_data_semaphore, portMAX_DELAY);
-    } else if (current_screen != main_screen.screen && new_screen == main_screen.screen) {
+    // Back on the main screen (or nothing found), hand over to the next scan.
+    if (new_screen == main_screen.screen) {
         xSemaphoreGive(background_scan_semaphore);
     }
 
-    if (new_screen != NULL) {
+    if (new_screen != current_screen) {
         lv_scr_load_anim(
             new_screen,
             LV_SCR_LOAD_ANIM_OVER_LEFT,
@@ -245,22 +257,8 @@ static void cycle_timer_cb(lv_timer_t *timer) {
 }
 
 
-void wifi_scanner(void) {
-    // Initialize NVS
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
-
-    background_scan_semaphore = xSemaphoreCreateBinary();
-    assert(background_scan_semaphore);
-    xSemaphoreGive(background_scan_semaphore);
-
-    scan_data_semaphore = xSemaphoreCreateBinary();
-    assert(scan_data_semaphore);
-
+// Runs in the LVGL task, posted from wifi_scanner().
+static void init_ui(void *arg) {
     init_styles();
     init_main_screen(&main_screen, "WiFi Scanner");
     assert(main_screen.screen);
@@ -268,11 +266,11 @@ void wifi_scanner(void) {
     assert(details_screen_1.screen);
     init_details_screen(&details_screen_2, "Network 2");
     assert(details_screen_2.screen);
+    scan_status = main_screen.status;
 
     lv_scr_load(main_screen.screen);
 
-    init_wifi();
-
+    // The scan task posts to the status label, start it once that exists.
     xTaskCreate(
         scan_networks,
         "WiFi Scan",
@@ -285,3 +283,28 @@ void wifi_scanner(void) {
     cycle_timer = lv_timer_create(cycle_timer_cb, 5000, NULL);
     assert(cycle_timer);
 }
+
+
+void wifi_scanner(void) {
+    // Initialize NVS
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+    boot_profile_mark("nvs");
+
+    background_scan_semaphore = xSemaphoreCreateBinary();
+    assert(background_scan_semaphore);
+    xSemaphoreGive(background_scan_semaphore);
+
+    scan_data_semaphore = xSemaphoreCreateBinary();
+    assert(scan_data_semaphore);
+
+    init_wifi();
+    boot_profile_mark("wifi init");
+
+    // Doesn't touch LVGL itself, the screens are built by the LVGL task.
+    ui_queue_call(init_ui, NULL);
+}
@@ -12,6 +12,9 @@
 #include "driver/gpio.h"
 #include "product_pins.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -20,14 +23,39 @@
     defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED_TOUCH) || \
     defined(CONFIG_LILYGO_T4_S3_241)
 
-#define SEND_BUF_SIZE           (16384)
+#include "lvgl.h"
+#include "amoled_driver.h"
+#include "boot_profile.h"
+#include "esp_timer.h"
+#include "qspi_panel.h"
+#include "panel_flush.h"
+
 #define DEFAULT_SPI_HANDLER     (SPI3_HOST)
 
 static const char *TAG = "AMOLED";
-static uint16_t *pBuffer = NULL;
-static spi_device_handle_t spi = NULL;
+static qspi_panel_t panel;
 static uint8_t _brightness;
 
+extern void display_flush_ready(void);
+
+// T4-S3 does not route TE to the ESP32
+#if CONFIG_LILYGO_AMOLED_TE_SYNC && (BOARD_DISP_TE != -1)
+#define AMOLED_TE_SYNC          1
+#endif
+
+#if AMOLED_TE_SYNC
+// A refresh period is ~16 ms, don't stall LVGL for long if TE stays silent
+#define TE_WAIT_TIMEOUT_MS      (50)
+#define TE_REPORT_FRAMES        (600)
+
+static SemaphoreHandle_t te_sem = NULL;
+static volatile uint32_t te_edges = 0;
+static volatile uint32_t te_frame_edge = 0;
+static volatile bool te_frame_pending = false;
+static amoled_te_stats_t te_stats;
+static uint32_t te_reported_missed = 0;
+#endif
+
 #ifndef LOW
 #define LOW 0
 #endif
@@ -46,6 +74,10 @@ void amoled_write_cmd(uint32_t cmd, uint8_t *pdat, uint32_t lenght);
 
 static bool __init_qspi_bus();
 
+static void amoled_init_write(uint8_t cmd, const uint8_t *param, uint8_t len);
+
+static void amoled_init_sync(void);
+
 #define delay(ms)   vTaskDelay(ms / portTICK_PERIOD_MS)
 
 static void pinMode(uint32_t gpio, uint8_t mode)
@@ -64,30 +96,94 @@ void digitalWrite(uint32_t gpio, uint8_t level)
     gpio_set_level((gpio_num_t )gpio, level);
 }
 
-static void inline setCS()
+#if AMOLED_TE_SYNC
+static void IRAM_ATTR amoled_te_isr(void *arg)
 {
-    digitalWrite(BOARD_DISP_CS, LOW);
+    BaseType_t woken = pdFALSE;
+    te_edges++;
+    xSemaphoreGiveFromISR(te_sem, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
 }
 
-static void inline clrCS()
+static void amoled_te_init()
 {
-    digitalWrite(BOARD_DISP_CS, HIGH);
+    te_sem = xSemaphoreCreateBinary();
+    assert(te_sem);
+
+    gpio_config_t config = {0};
+    config.pin_bit_mask = 1ULL << BOARD_DISP_TE;
+    config.mode = GPIO_MODE_INPUT;
+    config.pull_up_en = GPIO_PULLUP_DISABLE;
+    config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    config.intr_type = GPIO_INTR_POSEDGE;
+    ESP_ERROR_CHECK(gpio_config(&config));
+
+    // Someone else may have installed the service already
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add(BOARD_DISP_TE, amoled_te_isr, NULL));
 }
 
-void display_init()
+// Block until the panel starts a new refresh period
+void amoled_te_wait()
 {
-    __init_qspi_bus();
+    // A stale edge would start the transfer in the middle of a scan
+    xSemaphoreTake(te_sem, 0);
+    if (xSemaphoreTake(te_sem, pdMS_TO_TICKS(TE_WAIT_TIMEOUT_MS)) != pdTRUE) {
+        te_stats.te_timeouts++;
+    }
+    te_frame_edge = te_edges;
+    te_frame_pending = true;
+    te_stats.synced_frames++;
+
+    if ((te_stats.synced_frames % TE_REPORT_FRAMES) == 0 && te_stats.missed_vblanks != te_reported_missed) {
+        te_reported_missed = te_stats.missed_vblanks;
+        ESP_LOGW(TAG, "TE: %lu frames, %lu missed vblanks, %lu timeouts",
+                 te_stats.synced_frames, te_stats.missed_vblanks, te_stats.te_timeouts);
+    }
 }
 
-static bool __init_qspi_bus()
+// Every TE edge seen while the frame was still being sent is a refresh
+// period the transfer overran
+void IRAM_ATTR amoled_te_frame_done()
 {
-#if CONFIG_LILYGO_T_AMOLED_LITE_147
-    pBuffer = (uint16_t *)heap_caps_malloc(AMOLED_WIDTH * AMOLED_HEIGHT * sizeof(uint16_t), MALLOC_CAP_DMA);
-    if (!pBuffer) {
-        ESP_LOGE(TAG, "ERROR:No memory use .."); return false;
+    if (te_frame_pending) {
+        te_stats.missed_vblanks += te_edges - te_frame_edge;
+        te_frame_pending = false;
     }
+}
+
+void amoled_get_te_stats(amoled_te_stats_t *stats)
+{
+    *stats = te_stats;
+    stats->te_edges = te_edges;
+}
+#else
+void amoled_te_wait()
+{
+}
+
+void amoled_te_frame_done()
+{
+}
+
+void amoled_get_te_stats(amoled_te_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
 #endif
 
+void display_init()
+{
+    __init_qspi_bus();
+}
+
+static bool __init_qspi_bus()
+{
 #if defined(CONFIG_LILYGO_T_AMOLED_LITE_147)
     ESP_LOGI(TAG, "============LILYGO_T_AMOLED_LITE_147============");
 #elif defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED)
@@ -114,9 +210,9 @@ static bool __init_qspi_bus()
     pinMode(BOARD_DISP_RESET, OUTPUT);
     pinMode(BOARD_DISP_CS, OUTPUT);
 
-    if (BOARD_DISP_TE != -1) {
-        //
-    }
+#if AMOLED_TE_SYNC
+    amoled_te_init();
+#endif
 
     if (AMOLED_EN_PIN != -1) {
         pinMode(AMOLED_EN_PIN, OUTPUT);
@@ -130,6 +226,7 @@ static bool __init_qspi_bus()
     delay(300);
     digitalWrite(BOARD_DISP_RESET, HIGH);
     delay(200);
+    boot_profile_mark("panel reset");
 
     spi_bus_config_t buscfg = {
         .data0_io_num = BOARD_DISP_DATA0,
@@ -141,43 +238,38 @@ static bool __init_qspi_bus()
         .data5_io_num = BOARD_NONE_PIN,
         .data6_io_num = BOARD_NONE_PIN,
         .data7_io_num = BOARD_NONE_PIN,
-        .max_transfer_sz = (SEND_BUF_SIZE * 16) + 8,
+        .max_transfer_sz = (panel_flush_chunk_pixels() * 16) + 8,
         .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
     };
 
-    spi_device_interface_config_t devcfg = {
-        .command_bits = 8,
-        .address_bits = 24,
-        .mode = 0,
-        .clock_speed_hz = DEFAULT_SCK_SPEED,
-        .spics_io_num = -1,
-        .flags = SPI_DEVICE_HALFDUPLEX,
-        .queue_size = 17,
-    };
     esp_err_t ret = spi_bus_initialize(DEFAULT_SPI_HANDLER, &buscfg, SPI_DMA_CH_AUTO);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "spi_bus_initialize fail!");
         return false;
     }
-    ret = spi_bus_add_device(DEFAULT_SPI_HANDLER, &devcfg, &spi);
+    ret = panel_flush_attach_qspi(&panel, DEFAULT_SPI_HANDLER, DEFAULT_SCK_SPEED, BOARD_DISP_CS, display_flush_ready);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "spi_bus_add_device fail!");
         return false;
     }
+    boot_profile_mark("qspi bus");
     // prevent initialization failure
     int retry = 2;
     while (retry--) {
-        const lcd_cmd_t *t = AMOLED_INIT_CMD;
-        for (uint32_t i = 0; i < AMOLED_INIT_CMD_LEN; i++) {
-            amoled_write_cmd(t[i].addr, (uint8_t *)t[i].param, t[i].len & 0x1F);
-            if (t[i].len & 0x80) {
-                delay(120);
-            }
-            if (t[i].len & 0x20) {
-                delay(10);
-            }
-        }
+        init_seq_stats_t stats;
+        int64_t start = esp_timer_get_time();
+        init_seq_run(AMOLED_INIT_CMD, amoled_init_write, amoled_init_sync, &stats);
+        ESP_LOGI(TAG, "Init sequence: %u commands, %u bytes in %lld us plus %u ms delays",
+                 (unsigned)stats.cmds, (unsigned)stats.bytes,
+                 esp_timer_get_time() - start - stats.delay_ms * 1000LL, (unsigned)stats.delay_ms);
     }
+
+#if AMOLED_TE_SYNC
+    // TE on, V-blanking information only
+    lcd_cmd_t te_on = {0x3500, {0x00}, 0x01};
+    amoled_write_cmd(te_on.addr, te_on.param, te_on.len);
+#endif
+    boot_profile_mark("panel init");
     return true;
 }
 
@@ -193,21 +285,7 @@ uint16_t  amoled_height()
 
 void amoled_write_cmd(uint32_t cmd, uint8_t *pdat, uint32_t lenght)
 {
-    setCS();
-    spi_transaction_t t;
-    memset(&t, 0, sizeof(t));
-    t.flags = (SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR);
-    t.cmd = 0x02;
-    t.addr = cmd;
-    if (lenght != 0) {
-        t.tx_buffer = pdat;
-        t.length = 8 * lenght;
-    } else {
-        t.tx_buffer = NULL;
-        t.length = 0;
-    }
-    spi_device_polling_transmit(spi, &t);
-    clrCS();
+    qspi_panel_write_cmd(&panel, cmd, pdat, lenght);
 }
 
 void amoled_set_brightness(uint8_t level)
@@ -224,99 +302,32 @@ uint8_t amoled_get_brightness()
 
 void amoled_set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
 {
+    panel_flush_set_window(xs, ys, xe, ye);
+}
 
-#if CONFIG_LILYGO_T4_S3_241
-    xs += 16;
-    xe += 16;
-#endif
-
-    lcd_cmd_t t[3] = {
-        {
-            0x2A00, {
-                (uint8_t)((xs >> 8) & 0xFF),
-                (uint8_t)(xs & 0xFF),
-                (uint8_t)((xe >> 8) & 0xFF),
-                (uint8_t)(xe & 0xFF)
-            }, 0x04
-        },
-        {
-            0x2B00, {
-                (uint8_t)((ys >> 8) & 0xFF),
-                (uint8_t)(ys & 0xFF),
-                (uint8_t)((ye >> 8) & 0xFF),
-                (uint8_t)(ye & 0xFF)
-            }, 0x04
-        },
-        {
-            0x2C00, {
-                0x00
-            }, 0x00
-        },
-    };
-
-    for (uint32_t i = 0; i < 3; i++) {
-        amoled_write_cmd(t[i].addr, t[i].param, t[i].len);
-    }
+uint32_t amoled_get_elided_cmds()
+{
+    return panel_flush_elided_cmds();
 }
 
-// Push (aka write pixel) colours to the TFT (use amoled_set_window() first)
-void amoled_push_buffer(uint16_t *data, uint32_t len)
+// The init sequences are static, so their commands can be queued back to back
+// and only have to be waited for before a delay
+static void amoled_init_write(uint8_t cmd, const uint8_t *param, uint8_t len)
 {
-    bool first_send = true;
-    uint16_t *p = data;
-    assert(p);
-    assert(spi);
-    setCS();
-    do {
-        size_t chunk_size = len;
-        spi_transaction_ext_t t = {0};
-        memset(&t, 0, sizeof(t));
-        if (first_send) {
-            t.base.flags = SPI_TRANS_MODE_QIO;
-            t.base.cmd = 0x32 ;
-            t.base.addr = 0x002C00;
-            first_send = 0;
-        } else {
-            t.base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
-            t.command_bits = 0;
-            t.address_bits = 0;
-            t.dummy_bits = 0;
-        }
-        if (chunk_size > SEND_BUF_SIZE) {
-            chunk_size = SEND_BUF_SIZE;
-        }
-        t.base.tx_buffer = p;
-        t.base.length = chunk_size * 16;
-        spi_device_polling_transmit(spi, (spi_transaction_t *)&t);
-        len -= chunk_size;
-        p += chunk_size;
-    } while (len > 0);
-    clrCS();
+    qspi_panel_queue_cmd(&panel, (uint32_t)cmd << 8, param, len);
 }
 
-void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+static void amoled_init_sync(void)
 {
+    qspi_panel_wait(&panel, 0);
+}
 
-    if (pBuffer) {
-        assert(pBuffer);
-        uint16_t _x = AMOLED_WIDTH - (y + hight);
-        uint16_t _y = x;
-        uint16_t _h = width;
-        uint16_t _w = hight;
-        uint16_t *p = data;
-        uint32_t cum = 0;
-        for (uint16_t j = 0; j < width; j++) {
-            for (uint16_t i = 0; i < hight; i++) {
-                pBuffer[cum] = ((uint16_t)p[width * (hight - i - 1) + j]);
-                cum++;
-            }
-        }
-        amoled_set_window(_x, _y, _x + _w - 1, _y + _h - 1);
-        amoled_push_buffer(pBuffer, width * hight);
-    } else {
-        amoled_set_window(x, y, x + width - 1, y + hight - 1);
-        amoled_push_buffer(data, width * hight);
-    }
+// Push (aka write pixel) colours to the TFT (use amoled_set_window() first)
+// With CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER this returns as soon as all chunks
+// are queued, LVGL gets notified once the last one has been sent
+void amoled_push_buffer(uint16_t *data, uint32_t len)
+{
+    qspi_panel_push(&panel, data, len);
 }
 
 
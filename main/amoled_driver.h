@@ -7,6 +7,7 @@
  *
  */
 
+#pragma once
 #include <stdint.h>
 #include "product_pins.h"
 
@@ -14,6 +15,13 @@
 extern "C" {
 #endif
 
+typedef struct {
+    uint32_t te_edges;          // TE edges seen since init
+    uint32_t synced_frames;     // full frames started on a TE edge
+    uint32_t missed_vblanks;    // refresh periods overrun by a frame transfer
+    uint32_t te_timeouts;       // frames sent without seeing a TE edge
+} amoled_te_stats_t;
+
 void display_init();
 
 uint16_t  amoled_width();
@@ -28,8 +36,21 @@ void amoled_set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
 
 void amoled_push_buffer(uint16_t *data, uint32_t len);
 
+// Number of CASET/RASET commands amoled_set_window() did not have to send
+uint32_t amoled_get_elided_cmds();
+
+// Defined in panel_flush.cpp
 void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data);
 
+void amoled_get_te_stats(amoled_te_stats_t *stats);
+
+// Block until the panel starts a new refresh period, returns right away
+// without CONFIG_LILYGO_AMOLED_TE_SYNC
+void amoled_te_wait();
+
+// The last flush of a TE gated refresh is out, called from panel_flush.cpp
+void amoled_te_frame_done();
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file      display_batch.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <string.h>
+#include "display_batch.h"
+
+/*
+ * Cost of one more flushed area, in pixels that could be sent in the same
+ * time. Every area pays the LVGL render pass and flush callback, plus the
+ * window setup of the panel:
+ * QSPI: CASET, RASET and RAMWR as separate polled transactions
+ * i80:  three short bus transactions, pixels go out at 8 or 16 bit width
+ * SPI:  three command transactions at a much lower pixel rate
+ * RGB:  no window at all, just the copy into the frame buffer
+ */
+#define BATCH_RENDER_COST       (256)
+
+#if defined(CONFIG_LILYGO_T_AMOLED_LITE_147) || \
+    defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED) || \
+    defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED_TOUCH) || \
+    defined(CONFIG_LILYGO_T4_S3_241) || \
+    defined(CONFIG_LILYGO_T_DISPLAY_LONG)
+#define BATCH_WINDOW_COST       (512)
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3) || \
+    defined(CONFIG_LILYGO_T_HMI)
+#define BATCH_WINDOW_COST       (384)
+#elif defined(CONFIG_LILYGO_T_RGB)
+#define BATCH_WINDOW_COST       (0)
+#else
+#define BATCH_WINDOW_COST       (192)
+#endif
+
+#define BATCH_AREA_COST         (BATCH_RENDER_COST + BATCH_WINDOW_COST)
+
+static display_batch_stats_t batch_stats;
+
+void display_batch_render_start_cb(lv_disp_drv_t *drv)
+{
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    if (!disp || disp->driver != drv) {
+        return;
+    }
+
+    lv_area_t *areas = disp->inv_areas;
+    uint8_t *joined = disp->inv_area_joined;
+    uint16_t n = disp->inv_p;
+    bool merged;
+
+    batch_stats.frames++;
+    for (uint16_t i = 0; i < n; i++) {
+        if (!joined[i]) {
+            batch_stats.areas_in++;
+            batch_stats.pixels_in += lv_area_get_size(&areas[i]);
+        }
+    }
+
+    // LVGL picked the last area to flush before calling us, so an area is
+    // always folded into a later one and the last one stays in place
+    do {
+        merged = false;
+        for (uint16_t j = 1; j < n; j++) {
+            if (joined[j]) {
+                continue;
+            }
+            for (uint16_t i = 0; i < j; i++) {
+                if (joined[i]) {
+                    continue;
+                }
+                lv_area_t sum;
+                _lv_area_join(&sum, &areas[i], &areas[j]);
+                if (lv_area_get_size(&sum) <=
+                        lv_area_get_size(&areas[i]) + lv_area_get_size(&areas[j]) + BATCH_AREA_COST) {
+                    areas[j] = sum;
+                    joined[i] = 1;
+                    merged = true;
+                }
+            }
+        }
+    } while (merged);
+
+    for (uint16_t i = 0; i < n; i++) {
+        if (!joined[i]) {
+            batch_stats.areas_out++;
+            batch_stats.pixels_out += lv_area_get_size(&areas[i]);
+        }
+    }
+}
+
+void display_batch_get_stats(display_batch_stats_t *stats)
+{
+    memcpy(stats, &batch_stats, sizeof(batch_stats));
+}
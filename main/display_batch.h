@@ -0,0 +1,39 @@
+/**
+ * @file      display_batch.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t frames;            // refresh cycles seen
+    uint32_t areas_in;          // areas LVGL invalidated
+    uint32_t areas_out;         // areas left after coalescing
+    uint32_t pixels_in;         // pixels of the invalidated areas
+    uint32_t pixels_out;        // pixels actually rendered and flushed
+} display_batch_stats_t;
+
+/**
+ * @brief LVGL render_start_cb, coalesces the invalidated areas of a refresh
+ *
+ * Two areas are merged into their bounding box when flushing the extra
+ * pixels is cheaper than setting up one more window on the bus. The setup
+ * cost is expressed in pixels and depends on the display bus of the board.
+ */
+void display_batch_render_start_cb(lv_disp_drv_t *drv);
+
+void display_batch_get_stats(display_batch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
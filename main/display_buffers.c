@@ -0,0 +1,114 @@
+/**
+ * @file      display_buffers.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "lvgl.h"
+#include "display_buffers.h"
+#if CONFIG_SPIRAM
+#include "esp_cache.h"
+#endif
+
+static const char *TAG = "DRAW_BUF";
+
+#define INTERNAL_CAPS   (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
+
+// esp_wifi_init() takes its static RX buffers, about 1.6 KB each, after the
+// draw buffers are placed
+#ifdef CONFIG_ESP_WIFI_STATIC_RX_BUFFER_NUM
+#define WIFI_STATIC_RX_BYTES    (CONFIG_ESP_WIFI_STATIC_RX_BUFFER_NUM * 1600)
+#else
+#define WIFI_STATIC_RX_BYTES    (0)
+#endif
+
+#define INTERNAL_RESERVE_BYTES  (CONFIG_LILYGO_DRAW_BUF_INTERNAL_RESERVE_KB * 1024 + WIFI_STATIC_RX_BYTES)
+
+static uint32_t alloc_internal(void **buf1, void **buf2, uint32_t max_pixels,
+                               uint32_t min_pixels, uint32_t line_pixels)
+{
+    size_t free_bytes = heap_caps_get_free_size(INTERNAL_CAPS);
+    size_t largest = heap_caps_get_largest_free_block(INTERNAL_CAPS);
+
+    if (free_bytes <= INTERNAL_RESERVE_BYTES) {
+        return 0;
+    }
+    // Both buffers out of what is left above the reserve, each one in a
+    // single free block
+    uint32_t pixels = (free_bytes - INTERNAL_RESERVE_BYTES) / 2 / sizeof(lv_color_t);
+    if (pixels > largest / sizeof(lv_color_t)) {
+        pixels = largest / sizeof(lv_color_t);
+    }
+    if (pixels >= max_pixels) {
+        pixels = max_pixels;
+    } else {
+        pixels -= pixels % line_pixels;
+    }
+    if (pixels < min_pixels) {
+        ESP_LOGI(TAG, "Internal: %zu KB free, %d KB reserved, %lu px per buffer needed",
+                 free_bytes / 1024, INTERNAL_RESERVE_BYTES / 1024, (unsigned long)min_pixels);
+        return 0;
+    }
+
+    *buf1 = heap_caps_malloc(pixels * sizeof(lv_color_t), INTERNAL_CAPS);
+    *buf2 = heap_caps_malloc(pixels * sizeof(lv_color_t), INTERNAL_CAPS);
+    if (!*buf1 || !*buf2) {
+        // Fragmented after the first one
+        heap_caps_free(*buf1);
+        heap_caps_free(*buf2);
+        *buf1 = *buf2 = NULL;
+        return 0;
+    }
+    return pixels;
+}
+
+#if CONFIG_SPIRAM
+static uint32_t alloc_psram(void **buf1, void **buf2, uint32_t pixels)
+{
+    size_t align = 0;
+    if (esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &align) != ESP_OK || !align) {
+        align = 4;
+    }
+    // Round up so that no cache line is shared with other allocations
+    size_t bytes = (pixels * sizeof(lv_color_t) + align - 1) & ~(align - 1);
+
+    *buf1 = heap_caps_aligned_alloc(align, bytes, MALLOC_CAP_SPIRAM);
+    *buf2 = heap_caps_aligned_alloc(align, bytes, MALLOC_CAP_SPIRAM);
+    if (!*buf1 || !*buf2) {
+        heap_caps_free(*buf1);
+        heap_caps_free(*buf2);
+        *buf1 = *buf2 = NULL;
+        return 0;
+    }
+    ESP_LOGI(TAG, "PSRAM, %zu byte cache line alignment", align);
+    return pixels;
+}
+#endif
+
+uint32_t display_alloc_draw_buffers(void **buf1, void **buf2, uint32_t max_pixels,
+                                    uint32_t min_pixels, uint32_t line_pixels)
+{
+    uint32_t pixels = alloc_internal(buf1, buf2, max_pixels, min_pixels, line_pixels);
+    const char *tier = "internal";
+
+#if CONFIG_SPIRAM
+    if (!pixels) {
+        pixels = alloc_psram(buf1, buf2, max_pixels);
+        tier = "PSRAM";
+    }
+#endif
+    if (!pixels) {
+        ESP_LOGE(TAG, "No room for two %lu px draw buffers", (unsigned long)min_pixels);
+        return 0;
+    }
+    ESP_LOGI(TAG, "2 x %lu px (%lu lines, %lu KB) in %s, %zu KB internal DMA memory left",
+             (unsigned long)pixels, (unsigned long)(pixels / line_pixels),
+             (unsigned long)(pixels * sizeof(lv_color_t) / 1024), tier,
+             heap_caps_get_free_size(INTERNAL_CAPS) / 1024);
+    return pixels;
+}
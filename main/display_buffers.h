@@ -0,0 +1,36 @@
+/**
+ * @file      display_buffers.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocate LVGL's two draw buffers from the fastest memory that fits
+ *
+ * Internal DMA capable SRAM is used when both buffers fit next to the
+ * memory kept free for WiFi (LILYGO_DRAW_BUF_INTERNAL_RESERVE_KB plus its
+ * static RX buffers). The buffers are then trimmed to whole lines, but never
+ * below min_pixels. Otherwise both buffers of max_pixels go to PSRAM, aligned
+ * to the data cache line.
+ *
+ * @param max_pixels    pixels per buffer the refresh mode can make use of
+ * @param min_pixels    smallest useful buffer, max_pixels if a full frame is needed
+ * @param line_pixels   pixels per display line
+ * @return pixels per buffer, 0 if neither tier has room
+ */
+uint32_t display_alloc_draw_buffers(void **buf1, void **buf2, uint32_t max_pixels,
+                                    uint32_t min_pixels, uint32_t line_pixels);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+/**
+ * @file      display_convert.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <assert.h>
+#include <stdbool.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "pixel_ops.h"
+#include "display_convert.h"
+
+static const char *TAG = "CONVERT";
+
+#if CONFIG_LV_COLOR_16_SWAP
+#define LVGL_FORMAT     DISPLAY_FORMAT_RGB565_SWAPPED
+#else
+#define LVGL_FORMAT     DISPLAY_FORMAT_RGB565
+#endif
+
+static uint8_t *staging_buf = NULL;
+static uint32_t staging_pixels = 0;
+
+void display_convert_init(uint32_t max_pixels)
+{
+    if (DISPLAY_PANEL_FORMAT == LVGL_FORMAT) {
+        return;
+    }
+    if (DISPLAY_PANEL_FORMAT == DISPLAY_FORMAT_RGB666) {
+        staging_buf = heap_caps_aligned_alloc(4, max_pixels * DISPLAY_PANEL_BYTES_PER_PIXEL,
+                                              MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        assert(staging_buf);
+        staging_pixels = max_pixels;
+        ESP_LOGI(TAG, "RGB565 -> RGB666, %lu bytes staging", (unsigned long)(max_pixels * DISPLAY_PANEL_BYTES_PER_PIXEL));
+    } else {
+        ESP_LOGI(TAG, "RGB565 byte swap in place");
+    }
+}
+
+uint16_t *display_convert(uint16_t *data, uint32_t pixels)
+{
+    if (DISPLAY_PANEL_FORMAT == LVGL_FORMAT) {
+        return data;
+    }
+    if (DISPLAY_PANEL_FORMAT == DISPLAY_FORMAT_RGB666) {
+        assert(pixels <= staging_pixels);
+        pixel_rgb565_to_rgb666(staging_buf, data, pixels, LVGL_FORMAT == DISPLAY_FORMAT_RGB565_SWAPPED);
+        // The backend passes the pointer on untouched, the length comes
+        // from the panel's bits per pixel
+        return (uint16_t *)staging_buf;
+    }
+    // LVGL owns the buffer again only after display_flush_ready()
+    pixel_swap16(data, data, pixels);
+    return data;
+}
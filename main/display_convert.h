@@ -0,0 +1,56 @@
+/**
+ * @file      display_convert.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <sdkconfig.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DISPLAY_FORMAT_RGB565,          // little endian RGB565, LVGL's native order
+    DISPLAY_FORMAT_RGB565_SWAPPED,  // big endian RGB565, as clocked out on SPI, QSPI and i80
+    DISPLAY_FORMAT_RGB666,          // three bytes R, G, B, component in the upper six bits
+} display_format_t;
+
+// What the panel of the selected board expects from display_push_colors()
+#if CONFIG_LILYGO_DISPLAY_RGB666
+#define DISPLAY_PANEL_FORMAT            DISPLAY_FORMAT_RGB666
+#define DISPLAY_PANEL_BYTES_PER_PIXEL   (3)
+#elif CONFIG_LILYGO_T_RGB
+#define DISPLAY_PANEL_FORMAT            DISPLAY_FORMAT_RGB565
+#define DISPLAY_PANEL_BYTES_PER_PIXEL   (2)
+#else
+#define DISPLAY_PANEL_FORMAT            DISPLAY_FORMAT_RGB565_SWAPPED
+#define DISPLAY_PANEL_BYTES_PER_PIXEL   (2)
+#endif
+
+/**
+ * @brief Prepare the conversion stage
+ *
+ * Allocates a DMA capable staging buffer for max_pixels when the panel
+ * format is wider than LVGL's, nothing otherwise.
+ */
+void display_convert_init(uint32_t max_pixels);
+
+/**
+ * @brief Convert a rendered area to the panel format
+ *
+ * Runs between the flush callback and display_push_colors(). Byte order
+ * fixups are done in place, wider formats are written to the staging
+ * buffer. Returns the buffer to pass on, data itself when LVGL already
+ * renders in the panel format.
+ */
+uint16_t *display_convert(uint16_t *data, uint32_t pixels);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,7 @@
 #include "esp_idf_version.h"
 #include "driver/spi_master.h"
 #include "lvgl.h"
+#include "panel_flush.h"
 
 #if defined(CONFIG_LILYGO_T_DONGLE_S3)
 #include "esp_lcd_panel_st7735.h"
@@ -34,16 +35,11 @@
 static const char *TAG = "TFT";
 static esp_lcd_panel_io_handle_t io_handle = NULL;
 static esp_lcd_panel_handle_t panel_handle = NULL;
-extern lv_disp_drv_t disp_drv;
-
-void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
-{
-    esp_lcd_panel_draw_bitmap(panel_handle, x, y, width, hight, data);
-}
+extern void display_flush_ready(void);
 
 bool display_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
-    lv_disp_flush_ready(&disp_drv);
+    display_flush_ready();
     return false;
 }
 
@@ -65,7 +61,11 @@ void display_init()
         .miso_io_num = BOARD_SPI_MISO,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
+#if CONFIG_LILYGO_DISPLAY_RGB666
+        .max_transfer_sz = AMOLED_HEIGHT * 80 * 3,
+#else
         .max_transfer_sz = AMOLED_HEIGHT * 80 * sizeof(uint16_t),
+#endif
     };
     ESP_ERROR_CHECK(spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO));
 
@@ -87,7 +87,12 @@ void display_init()
     esp_lcd_panel_dev_config_t panel_config = {
         .reset_gpio_num = BOARD_TFT_RST,
         .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_BGR,
+#if CONFIG_LILYGO_DISPLAY_RGB666
+        // display_convert() expands LVGL's RGB565 for this
+        .bits_per_pixel = 18,
+#else
         .bits_per_pixel = 16,
+#endif
     };
 #if defined(CONFIG_LILYGO_T_DISPLAY) ||\
     defined(CONFIG_LILYGO_T_DONGLE_S2)
@@ -101,25 +106,8 @@ void display_init()
     ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
 
-#if defined(CONFIG_LILYGO_T_DISPLAY)
-    ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel_handle, true));
-    esp_lcd_panel_swap_xy(panel_handle, true);
-    ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, false, true));
-    esp_lcd_panel_set_gap(panel_handle, 40, 53);
-#elif defined(CONFIG_LILYGO_T_DONGLE_S2)
-    ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel_handle, true));
-    esp_lcd_panel_swap_xy(panel_handle, false);
-    ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, false, false));
-    esp_lcd_panel_set_gap(panel_handle, 53, 40);
-#elif defined(CONFIG_LILYGO_T_DONGLE_S3)
-    ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel_handle, true));
-    esp_lcd_panel_set_gap(panel_handle, 26, 1);
-    // esp_lcd_panel_swap_xy(panel_handle, true);
-    // ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, false, true));
-#else
-
-
-#endif
+    // Inversion, orientation and gap of the board, see panel_traits.hpp
+    panel_flush_attach_lcd(panel_handle);
 
     ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
 
@@ -17,6 +17,7 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "product_pins.h"
+#include "panel_flush.h"
 
 #if CONFIG_LILYGO_T_HMI
 
@@ -32,17 +33,12 @@ static esp_lcd_panel_io_handle_t io_handle = NULL;
 static esp_lcd_panel_handle_t panel_handle = NULL;
 static esp_lcd_touch_handle_t tp = NULL;
 
-extern lv_disp_drv_t disp_drv;
+extern void display_flush_ready(void);
 
 
-void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
-{
-    esp_lcd_panel_draw_bitmap(panel_handle, x, y, width, hight, data);
-}
-
 bool display_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
-    lv_disp_flush_ready(&disp_drv);
+    display_flush_ready();
     return false;
 }
 
@@ -103,9 +99,8 @@ void display_init()
 
     esp_lcd_panel_init(panel_handle);
 
-    esp_lcd_panel_mirror(panel_handle, false, true);
-
-    esp_lcd_panel_swap_xy(panel_handle, true);
+    // Orientation of the board, see panel_traits.hpp
+    panel_flush_attach_lcd(panel_handle);
 
     esp_lcd_panel_disp_on_off(panel_handle, true);
 
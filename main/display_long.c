@@ -12,18 +12,24 @@
 #include "driver/gpio.h"
 #include "product_pins.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include <stdlib.h>
 #include <string.h>
 #include "esp_lcd_panel_vendor.h"
 
 #if CONFIG_LILYGO_T_DISPLAY_LONG
 
-#define SEND_BUF_SIZE           (14400)
+#include "lvgl.h"
+#include "qspi_panel.h"
+#include "panel_flush.h"
+
 #define DEFAULT_SPI_HANDLER     (SPI3_HOST)
 
 static const char *TAG = "LONG";
-static spi_device_handle_t spi = NULL;
+static qspi_panel_t panel;
+extern void display_flush_ready(void);
 static void amoled_write_cmd(uint32_t cmd, uint8_t *pdat, uint32_t lenght);
+static void amoled_init_write(uint8_t cmd, const uint8_t *param, uint8_t len);
 
 
 #define delay(ms)   vTaskDelay(ms / portTICK_PERIOD_MS)
@@ -42,11 +48,12 @@ static void amoled_write_cmd(uint32_t cmd, uint8_t *pdat, uint32_t lenght);
 
 
 
-static const lcd_cmd_t vendor_config[] = {
-    {0x28, {0x00}, 0x40},
-    {0x10, {0x00}, 0x20},
-    {0x11, {0x00}, 0x80},
-    {0x29, {0x00}, 0x00},
+static const uint8_t vendor_config[] = {
+    INIT_CMD0_DELAY(0x28, 20),
+    INIT_CMD0_DELAY(0x10, 10),
+    INIT_CMD0_DELAY(0x11, 200),
+    INIT_CMD0(0x29),
+    INIT_SEQ_END
 };
 
 static void pinMode(uint32_t gpio, uint8_t mode)
@@ -65,15 +72,6 @@ static void digitalWrite(uint32_t gpio, uint8_t level)
     gpio_set_level((gpio_num_t )gpio, level);
 }
 
-static void inline setCS()
-{
-    digitalWrite(BOARD_DISP_CS, LOW);
-}
-
-static void inline clrCS()
-{
-    digitalWrite(BOARD_DISP_CS, HIGH);
-}
 
 bool display_init()
 {
@@ -115,43 +113,23 @@ bool display_init()
         .data5_io_num = BOARD_NONE_PIN,
         .data6_io_num = BOARD_NONE_PIN,
         .data7_io_num = BOARD_NONE_PIN,
-        .max_transfer_sz = (SEND_BUF_SIZE * 16) + 8,
+        .max_transfer_sz = (panel_flush_chunk_pixels() * 16) + 8,
         .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
     };
 
-    spi_device_interface_config_t devcfg = {
-        .command_bits = 8,
-        .address_bits = 24,
-        .mode = 0,
-        .clock_speed_hz = DEFAULT_SCK_SPEED,
-        .spics_io_num = -1,
-        .flags = SPI_DEVICE_HALFDUPLEX,
-        .queue_size = 17,
-    };
     esp_err_t ret = spi_bus_initialize(DEFAULT_SPI_HANDLER, &buscfg, SPI_DMA_CH_AUTO);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "spi_bus_initialize fail!");
         return false;
     }
-    ret = spi_bus_add_device(DEFAULT_SPI_HANDLER, &devcfg, &spi);
+    // Chunking and RAMWRC framing come from BoardMount in panel_traits.hpp
+    ret = panel_flush_attach_qspi(&panel, DEFAULT_SPI_HANDLER, DEFAULT_SCK_SPEED, BOARD_DISP_CS, display_flush_ready);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "spi_bus_add_device fail!");
         return false;
     }
 
-    int i = 1;
-    while (i--) {
-        const lcd_cmd_t *lcd_init = vendor_config;
-        for (int i = 0; i < sizeof(vendor_config) / sizeof(lcd_cmd_t); i++) {
-            amoled_write_cmd(lcd_init[i].addr,
-                             lcd_init[i].param,
-                             lcd_init[i].len & 0x3f);
-            if (lcd_init[i].len & 0x80)
-                delay(200);
-            if (lcd_init[i].len & 0x40)
-                delay(20);
-        }
-    }
+    init_seq_run(vendor_config, amoled_init_write, NULL, NULL);
 
     digitalWrite(BOARD_DISP_BL, HIGH);
     return true;
@@ -159,97 +137,15 @@ bool display_init()
 
 static void amoled_write_cmd(uint32_t cmd, uint8_t *pdat, uint32_t lenght)
 {
-    setCS();
-    spi_transaction_t t;
-    memset(&t, 0, sizeof(t));
-    t.flags = (SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR);
-    t.cmd = 0x02;
-    t.addr = cmd << 8;
-    if (lenght != 0) {
-        t.tx_buffer = pdat;
-        t.length = 8 * lenght;
-    } else {
-        t.tx_buffer = NULL;
-        t.length = 0;
-    }
-    spi_device_polling_transmit(spi, &t);
-    clrCS();
-}
-
-
-static void amoled_set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
-{
-    lcd_cmd_t t[2] = {
-        {
-            0x2A, {
-                (uint8_t)((xs >> 8) & 0xFF),
-                (uint8_t)(xs & 0xFF),
-                (uint8_t)((xe >> 8) & 0xFF),
-                (uint8_t)(xe & 0xFF)
-            }, 0x04
-        },
-        {
-            0x2B, {
-                (uint8_t)((ys >> 8) & 0xFF),
-                (uint8_t)(ys & 0xFF),
-                (uint8_t)((ye >> 8) & 0xFF),
-                (uint8_t)(ye & 0xFF)
-            }, 0x04
-        },
-    };
-
-    for (uint32_t i = 0; i < sizeof(t) / sizeof(t[0]); i++) {
-        amoled_write_cmd(t[i].addr, t[i].param, t[i].len);
-    }
+    qspi_panel_write_cmd(&panel, cmd << 8, pdat, lenght);
 }
 
 
-// Push (aka write pixel) colours to the TFT (use amoled_set_window() first)
-static void amoled_push_buffer(uint16_t *data, uint32_t len)
+// amoled_write_cmd() polls, nothing is left in flight between commands
+static void amoled_init_write(uint8_t cmd, const uint8_t *param, uint8_t len)
 {
-    bool first_send = true;
-    uint16_t *p = data;
-    assert(p);
-    assert(spi);
-    do {
-        setCS();
-        size_t chunk_size = len;
-        spi_transaction_ext_t t = {0};
-
-        memset(&t, 0, sizeof(t));
-        t.base.flags = SPI_TRANS_MODE_QIO;
-        t.base.cmd = 0x32 ;
-
-        if (first_send) {
-            t.base.addr = 0x002C00;
-        } else {
-            t.base.addr = 0x003C00;
-        }
-        first_send = 0;
-
-        if (chunk_size > SEND_BUF_SIZE) {
-            chunk_size = SEND_BUF_SIZE;
-        }
-
-        t.base.tx_buffer = p;
-        t.base.length = chunk_size * 16;
-        if (!first_send) {
-            clrCS();
-        }
-
-        setCS();
-
-        spi_device_polling_transmit(spi, (spi_transaction_t *)&t);
-        len -= chunk_size;
-        p += chunk_size;
-    } while (len > 0);
-    clrCS();
+    amoled_write_cmd(cmd, (uint8_t *)param, len);
 }
 
-void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
-{
-    amoled_set_window(x, y, x + width - 1, y + hight - 1);
-    amoled_push_buffer(data, width * hight);
-}
 #endif
 
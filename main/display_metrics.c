@@ -0,0 +1,212 @@
+/**
+ * @file      display_metrics.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "display_metrics.h"
+
+static const char *TAG = "METRICS";
+
+static portMUX_TYPE metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+static display_metrics_t metrics;
+
+// Owned by the LVGL task
+static int64_t last_begin_us = 0;       // previous flush_cb or start of the cycle
+static int64_t wait_start_us = 0;       // first wait_cb since the last flush_cb
+
+// The area on its way to the panel, finished from the backend's ISR
+static volatile int64_t transfer_begin_us = 0;
+static volatile int64_t transfer_end_us = 0;
+static volatile uint32_t transfer_bytes = 0;
+
+static void IRAM_ATTR hist_add(display_hist_t *h, uint32_t value)
+{
+    uint32_t bucket = value ? 31 - __builtin_clz(value) : 0;
+    if (bucket >= DISPLAY_METRICS_BUCKETS) {
+        bucket = DISPLAY_METRICS_BUCKETS - 1;
+    }
+    if (!h->count || value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->count++;
+    h->sum += value;
+    h->buckets[bucket]++;
+}
+
+void display_metrics_render_start(void)
+{
+    last_begin_us = esp_timer_get_time();
+    wait_start_us = 0;
+    portENTER_CRITICAL(&metrics_lock);
+    metrics.refreshes++;
+    portEXIT_CRITICAL(&metrics_lock);
+}
+
+void display_metrics_wait(void)
+{
+    if (!wait_start_us) {
+        wait_start_us = esp_timer_get_time();
+    }
+}
+
+void display_metrics_flush_begin(uint32_t pixels, uint32_t bytes)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&metrics_lock);
+    // Everything since the previous flush_cb was rendering, except the time
+    // LVGL spent in wait_cb until the previous transfer was done
+    uint32_t wait = 0;
+    if (wait_start_us && transfer_end_us > wait_start_us) {
+        wait = transfer_end_us - wait_start_us;
+    }
+    uint32_t elapsed = last_begin_us ? now - last_begin_us : 0;
+    hist_add(&metrics.render_us, elapsed > wait ? elapsed - wait : 0);
+    if (wait_start_us) {
+        hist_add(&metrics.wait_us, wait);
+    }
+    metrics.flushes++;
+    metrics.pixels += pixels;
+    metrics.bytes += bytes;
+    transfer_begin_us = now;
+    transfer_bytes = bytes;
+    portEXIT_CRITICAL(&metrics_lock);
+
+    last_begin_us = now;
+    wait_start_us = 0;
+}
+
+void IRAM_ATTR display_metrics_flush_end(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_SAFE(&metrics_lock);
+    uint32_t us = now - transfer_begin_us;
+    hist_add(&metrics.transfer_us, us);
+    // One byte per us is 1 MB/s
+    hist_add(&metrics.throughput_kbs, us ? (uint32_t)((uint64_t)transfer_bytes * 1000 / us) : 0);
+    transfer_end_us = now;
+    portEXIT_CRITICAL_SAFE(&metrics_lock);
+}
+
+void display_metrics_timer_handler(uint32_t us)
+{
+    portENTER_CRITICAL(&metrics_lock);
+    hist_add(&metrics.handler_us, us);
+    portEXIT_CRITICAL(&metrics_lock);
+}
+
+void display_metrics_worker(uint32_t queued_us, uint32_t busy_us)
+{
+    portENTER_CRITICAL(&metrics_lock);
+    hist_add(&metrics.queue_us, queued_us);
+    hist_add(&metrics.worker_us, busy_us);
+    portEXIT_CRITICAL(&metrics_lock);
+}
+
+void display_metrics_get(display_metrics_t *out, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&metrics_lock);
+    memcpy(out, &metrics, sizeof(metrics));
+    out->until_us = now;
+    if (reset) {
+        memset(&metrics, 0, sizeof(metrics));
+        metrics.since_us = now;
+    }
+    portEXIT_CRITICAL(&metrics_lock);
+}
+
+static void dump_hist(const char *name, const display_hist_t *h)
+{
+    // Room for the widest uint32_t count, a separator each
+    char line[DISPLAY_METRICS_BUCKETS * 11 + 1];
+    size_t pos = 0;
+
+    if (!h->count) {
+        ESP_LOGI(TAG, "%-10s n=0", name);
+        return;
+    }
+    line[0] = '\0';
+    for (int i = 0; i < DISPLAY_METRICS_BUCKETS && pos < sizeof(line); i++) {
+        pos += snprintf(line + pos, sizeof(line) - pos, " %5lu", (unsigned long)h->buckets[i]);
+    }
+    ESP_LOGI(TAG, "%-10s n=%lu min=%lu avg=%lu max=%lu |%s", name,
+             (unsigned long)h->count, (unsigned long)h->min,
+             (unsigned long)(h->sum / h->count), (unsigned long)h->max, line);
+}
+
+void display_metrics_dump(void)
+{
+    display_metrics_t m;
+    display_metrics_get(&m, true);
+
+    uint64_t window = m.until_us - m.since_us;
+    if (!window) {
+        return;
+    }
+    ESP_LOGI(TAG, "%lu refreshes (%.1f fps), %lu flushes in %lu ms, %llu px, %llu KB",
+             (unsigned long)m.refreshes, m.refreshes * 1000000.0 / window,
+             (unsigned long)m.flushes, (unsigned long)(window / 1000),
+             m.pixels, m.bytes / 1024);
+    ESP_LOGI(TAG, "bus %.2f MB/s while busy, busy %lu%%, render busy %lu%%",
+             m.transfer_us.sum ? (double)m.bytes / m.transfer_us.sum : 0.0,
+             (unsigned long)(m.transfer_us.sum * 100 / window),
+             (unsigned long)(m.render_us.sum * 100 / window));
+    if (m.worker_us.count) {
+        // Per stage share of the window: LVGL task, flush worker, bus
+        ESP_LOGI(TAG, "stage busy: lvgl %lu%%, flush worker %lu%%, bus %lu%%",
+                 (unsigned long)(m.handler_us.sum * 100 / window),
+                 (unsigned long)(m.worker_us.sum * 100 / window),
+                 (unsigned long)(m.transfer_us.sum * 100 / window));
+    }
+    ESP_LOGI(TAG, "buckets are powers of two, 1 2 4 8 ...");
+    dump_hist("render us", &m.render_us);
+    dump_hist("wait us", &m.wait_us);
+    dump_hist("xfer us", &m.transfer_us);
+    dump_hist("xfer KB/s", &m.throughput_kbs);
+    dump_hist("timer us", &m.handler_us);
+    if (m.worker_us.count) {
+        dump_hist("queue us", &m.queue_us);
+        dump_hist("worker us", &m.worker_us);
+    }
+}
+
+#if CONFIG_LILYGO_DISPLAY_METRICS_INTERVAL > 0
+static void display_metrics_timer_cb(void *arg)
+{
+    display_metrics_dump();
+}
+#endif
+
+void display_metrics_init(void)
+{
+    metrics.since_us = esp_timer_get_time();
+#if CONFIG_LILYGO_DISPLAY_METRICS_INTERVAL > 0
+    const esp_timer_create_args_t args = {
+        .callback = &display_metrics_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "disp_metrics",
+        .skip_unhandled_events = true
+    };
+    esp_timer_handle_t timer = NULL;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_LILYGO_DISPLAY_METRICS_INTERVAL * 1000000ULL));
+#endif
+}
@@ -0,0 +1,73 @@
+/**
+ * @file      display_metrics.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bucket i counts samples in [2^i, 2^(i+1)), the last one everything above
+#define DISPLAY_METRICS_BUCKETS     (16)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[DISPLAY_METRICS_BUCKETS];
+} display_hist_t;
+
+typedef struct {
+    int64_t since_us;               // start of the measurement window
+    int64_t until_us;               // time of the snapshot
+    uint32_t refreshes;             // LVGL refresh cycles
+    uint32_t flushes;
+    uint64_t pixels;
+    uint64_t bytes;                 // bytes clocked out to the panel
+    display_hist_t render_us;       // LVGL rendering one area
+    display_hist_t wait_us;         // LVGL waiting for the previous transfer
+    display_hist_t transfer_us;     // flush_cb until the backend reports done
+    display_hist_t throughput_kbs;  // bytes per transfer time, in KB/s
+    display_hist_t handler_us;      // one lv_timer_handler() run
+    display_hist_t queue_us;        // flush descriptor waiting for the worker
+    display_hist_t worker_us;       // flush worker preparing and submitting an area
+} display_metrics_t;
+
+// Called from LVGL's render_start_cb, a new refresh cycle begins
+void display_metrics_render_start(void);
+
+// Called from LVGL's wait_cb while LVGL waits for a transfer
+void display_metrics_wait(void);
+
+// Called from the flush callback before the area is handed to the backend
+void display_metrics_flush_begin(uint32_t pixels, uint32_t bytes);
+
+// Called when the backend is done with the area, safe from an ISR
+void display_metrics_flush_end(void);
+
+void display_metrics_timer_handler(uint32_t us);
+
+// Called from the flush worker after it handed an area to the backend
+void display_metrics_worker(uint32_t queued_us, uint32_t busy_us);
+
+// Copy the current window, optionally starting a new one
+void display_metrics_get(display_metrics_t *metrics, bool reset);
+
+// Log a summary of the current window and start a new one
+void display_metrics_dump(void);
+
+// Dump every CONFIG_LILYGO_DISPLAY_METRICS_INTERVAL seconds, 0 disables it
+void display_metrics_init(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file      display_pipeline.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+
+#if CONFIG_LILYGO_DISPLAY_PIPELINE
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "display_convert.h"
+#include "display_metrics.h"
+#include "panel_flush.h"
+#include "display_pipeline.h"
+
+#define FLUSH_TASK_STACK_SIZE   (3 * 1024)
+// Above the LVGL task, a queued descriptor should not wait for rendering
+#define FLUSH_TASK_PRIORITY     (3)
+
+static const char *TAG = "PIPELINE";
+
+extern void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data);
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t hight;
+    uint16_t *data;
+    uint32_t pixels;
+    bool frame_start;
+    bool frame_end;
+    int64_t queued_us;
+} flush_desc_t;
+
+static QueueHandle_t flush_queue = NULL;
+
+static void display_pipeline_task(void *arg)
+{
+    flush_desc_t desc;
+
+    ESP_LOGI(TAG, "Flush worker running on core %d", xPortGetCoreID());
+    while (1) {
+        if (xQueueReceive(flush_queue, &desc, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        // Returns once the area is on its way, the backend reports the end
+        // of the transfer through display_flush_ready()
+        uint16_t *data = display_convert(desc.data, desc.pixels);
+        panel_flush_set_frame(desc.frame_start, desc.frame_end);
+        display_push_colors(desc.x, desc.y, desc.width, desc.hight, data);
+        display_metrics_worker(start - desc.queued_us, esp_timer_get_time() - start);
+    }
+}
+
+void display_pipeline_init(void)
+{
+    flush_queue = xQueueCreate(CONFIG_LILYGO_DISPLAY_PIPELINE_DEPTH, sizeof(flush_desc_t));
+    assert(flush_queue);
+    BaseType_t ret = xTaskCreatePinnedToCore(display_pipeline_task, "flush", FLUSH_TASK_STACK_SIZE, NULL,
+                     FLUSH_TASK_PRIORITY, NULL, CONFIG_LILYGO_DISPLAY_PIPELINE_FLUSH_CORE);
+    assert(ret == pdPASS);
+}
+
+void display_pipeline_submit(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data,
+                             uint32_t pixels, bool frame_start, bool frame_end)
+{
+    flush_desc_t desc = {
+        .x = x,
+        .y = y,
+        .width = width,
+        .hight = hight,
+        .data = data,
+        .pixels = pixels,
+        .frame_start = frame_start,
+        .frame_end = frame_end,
+        .queued_us = esp_timer_get_time(),
+    };
+    xQueueSend(flush_queue, &desc, portMAX_DELAY);
+}
+
+#endif /*CONFIG_LILYGO_DISPLAY_PIPELINE*/
@@ -0,0 +1,43 @@
+/**
+ * @file      display_pipeline.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the flush worker
+ *
+ * The worker is pinned to CONFIG_LILYGO_DISPLAY_PIPELINE_FLUSH_CORE and runs
+ * display_push_colors() for every descriptor handed over with
+ * display_pipeline_submit(), so rotation, byte order fixes, window setup and
+ * DMA submission no longer run on the core LVGL renders on.
+ */
+void display_pipeline_init(void);
+
+/**
+ * @brief Queue a draw buffer for the flush worker
+ *
+ * Takes the same arguments as display_push_colors() plus the number of
+ * pixels in the area, the worker runs display_convert() on them before
+ * handing them to the backend. frame_start and frame_end go along to
+ * panel_flush_set_frame(). The buffer belongs to
+ * the worker until the backend calls display_flush_ready(). Blocks while
+ * CONFIG_LILYGO_DISPLAY_PIPELINE_DEPTH descriptors are already queued.
+ */
+void display_pipeline_submit(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data,
+                             uint32_t pixels, bool frame_start, bool frame_end);
+
+#ifdef __cplusplus
+}
+#endif
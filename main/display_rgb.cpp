@@ -7,6 +7,7 @@
  *
  */
 #include <sdkconfig.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -14,10 +15,13 @@
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_rgb.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "product_pins.h"
 #include "i2c_driver.h"
+#include "panel_flush.h"
 
 #if CONFIG_LILYGO_T_RGB
 
@@ -34,9 +38,9 @@ static SemaphoreHandle_t sem_vsync_end;
 static SemaphoreHandle_t sem_gui_ready;
 static esp_lcd_panel_handle_t panel_handle = NULL;
 
-extern lv_disp_drv_t disp_drv;
+extern "C" void display_flush_ready(void);
 
-const lcd_cmd_t *init_cmd = st7701_2_1_inches;
+const uint8_t *init_cmd = st7701_2_1_inches;
 extern i2c_master_bus_handle_t bus_handle;
 TouchDrvInterface *touchDrv;
 void *buf1 = NULL;
@@ -52,11 +56,54 @@ ExtensionIOXL9555::ExtensionGPIO sdmmc_cs = ExtensionIOXL9555::IO7;
 ExtensionIOXL9555::ExtensionGPIO tp_reset = ExtensionIOXL9555::IO1;
 
 
+#if CONFIG_LILYGO_T_RGB_DIRECT_MODE
+// A frame buffer switch is pending: hand the vsync to the flushing task
+static bool IRAM_ATTR display_on_vsync(esp_lcd_panel_handle_t panel, const esp_lcd_rgb_panel_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t high_task_awoken = pdFALSE;
+    if (xSemaphoreTakeFromISR(sem_gui_ready, &high_task_awoken) == pdTRUE) {
+        xSemaphoreGiveFromISR(sem_vsync_end, &high_task_awoken);
+    }
+    return high_task_awoken == pdTRUE;
+}
+
+// Bring the buffer LVGL renders the next frame into up to date with the one
+// on screen, only the areas redrawn in this frame differ
+static void display_sync_dirty(lv_disp_t *disp, const uint16_t *front, uint16_t *back)
+{
+    const uint32_t stride = disp->driver->hor_res;
+
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (disp->inv_area_joined[i]) {
+            continue;
+        }
+        const lv_area_t *area = &disp->inv_areas[i];
+        size_t bytes = lv_area_get_width(area) * sizeof(uint16_t);
+        uint32_t offset = area->y1 * stride + area->x1;
+        for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+            memcpy(back + offset, front + offset, bytes);
+            offset += stride;
+        }
+    }
+}
+
+// LVGL renders straight into the panel's frame buffers, data is the whole
+// frame. Only the last area of a refresh switches the buffers.
 extern "C" void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
 {
-    esp_lcd_panel_draw_bitmap(panel_handle, x, y, width, hight, data);
-    lv_disp_flush_ready(&disp_drv);
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+
+    if (lv_disp_flush_is_last(disp->driver)) {
+        // Only records data as the buffer to scan out from the next frame on
+        esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, AMOLED_WIDTH, AMOLED_HEIGHT, data);
+        // Wait until that frame started, the other buffer is then off screen
+        xSemaphoreGive(sem_gui_ready);
+        xSemaphoreTake(sem_vsync_end, portMAX_DELAY);
+        display_sync_dirty(disp, data, (uint16_t *)(data == buf1 ? buf2 : buf1));
+    }
+    display_flush_ready();
 }
+#endif
 
 static void writeCommand(const uint8_t cmd)
 {
@@ -76,6 +123,99 @@ static void writeData(const uint8_t *data, int len)
     } while (len--);
 }
 
+#if CONFIG_LILYGO_T_RGB_BULK_INIT
+#define XL9555_REG_OUTPUT_PORT0     (0x02)
+#define XL9555_I2C_FREQ_HZ          (400000)
+// A 9 bit word is CS low, 9 x (clock low, clock high), CS high
+#define BULK_STATES_PER_WORD        (2 + 9 * 2)
+// Command word plus up to 31 parameters (len & 0x1F)
+#define BULK_MAX_WORDS              (32)
+
+static i2c_master_dev_handle_t xl9555_dev = NULL;
+static uint8_t xl9555_port[2];      // output port registers as last written
+// Register address, then one byte per port for every pin state: a multi
+// byte write alternates between the two output port registers
+static uint8_t bulk_buf[1 + BULK_MAX_WORDS * BULK_STATES_PER_WORD * 2];
+static size_t bulk_len = 0;
+static size_t bulk_total = 0;
+
+static void bulk_push(uint8_t port0)
+{
+    // Only states where a pin actually changes cost I2C bytes
+    if (port0 == xl9555_port[0]) {
+        return;
+    }
+    bulk_buf[bulk_len++] = port0;
+    bulk_buf[bulk_len++] = xl9555_port[1];
+    xl9555_port[0] = port0;
+}
+
+// Same waveform as ExtensionIOXL9555::transfer9(): MSB first, data set
+// with the falling edge, sampled by the panel on the rising edge
+static void bulk_word(uint16_t word)
+{
+    const uint8_t cs_bit = 1 << cs, sclk_bit = 1 << sclk, mosi_bit = 1 << mosi;
+    uint8_t port0 = xl9555_port[0] & ~(cs_bit | sclk_bit);
+
+    bulk_push(port0);
+    for (int i = 8; i >= 0; i--) {
+        port0 &= ~(sclk_bit | mosi_bit);
+        if (word & (1 << i)) {
+            port0 |= mosi_bit;
+        }
+        bulk_push(port0);
+        bulk_push(port0 | sclk_bit);
+    }
+    bulk_push(port0 | sclk_bit | cs_bit);
+}
+
+// One I2C write per command instead of several read-modify-write
+// transactions per bit
+static esp_err_t bulk_write_command(uint8_t cmd, const uint8_t *param, int len)
+{
+    bulk_len = 0;
+    bulk_buf[bulk_len++] = XL9555_REG_OUTPUT_PORT0;
+    bulk_word(cmd);
+    for (int i = 0; i < len; i++) {
+        bulk_word(param[i] | 1 << 8);
+    }
+    bulk_total += bulk_len;
+    return i2c_master_transmit(xl9555_dev, bulk_buf, bulk_len, 1000);
+}
+
+static void bulk_init_write(uint8_t cmd, const uint8_t *param, uint8_t len)
+{
+    ESP_ERROR_CHECK(bulk_write_command(cmd, param, len));
+}
+
+static esp_err_t bulk_begin()
+{
+    assert(cs < 8 && mosi < 8 && sclk < 8);
+    i2c_device_config_t dev_cfg = {};
+    dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_cfg.device_address = XL9555_SLAVE_ADDRESS0;
+    dev_cfg.scl_speed_hz = XL9555_I2C_FREQ_HZ;
+    esp_err_t err = i2c_master_bus_add_device(bus_handle, &dev_cfg, &xl9555_dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // Start from the current pin levels, reading port 0 continues with port 1
+    uint8_t reg = XL9555_REG_OUTPUT_PORT0;
+    err = i2c_master_transmit_receive(xl9555_dev, &reg, 1, xl9555_port, 2, 1000);
+    if (err != ESP_OK) {
+        i2c_master_bus_rm_device(xl9555_dev);
+        xl9555_dev = NULL;
+    }
+    return err;
+}
+#else
+static void legacy_init_write(uint8_t cmd, const uint8_t *param, uint8_t len)
+{
+    writeCommand(cmd);
+    writeData(param, len);
+}
+#endif
+
 extern "C" void display_init()
 {
     assert(init_cmd);
@@ -91,15 +231,22 @@ extern "C" void display_init()
     ESP_LOGI(TAG, "Extension BEGIN SPI SUCCESS !");
     extension.beginSPI(mosi, -1, sclk, cs);
 
-    int i = 0;
-    while (init_cmd[i].len != 0xff) {
-        writeCommand(init_cmd[i].addr);
-        writeData(init_cmd[i].param, init_cmd[i].len & 0x1F);
-        if (init_cmd[i].len & 0x80) {
-            delay(100);
-        }
-        i++;
-    }
+    init_seq_stats_t stats;
+    int64_t start = esp_timer_get_time();
+#if CONFIG_LILYGO_T_RGB_BULK_INIT
+    ESP_ERROR_CHECK(bulk_begin());
+    init_seq_run(init_cmd, bulk_init_write, NULL, &stats);
+    i2c_master_bus_rm_device(xl9555_dev);
+    xl9555_dev = NULL;
+    ESP_LOGI(TAG, "Init table: %u commands in %lld us plus %u ms delays, %u bytes over I2C",
+             (unsigned)stats.cmds, esp_timer_get_time() - start - stats.delay_ms * 1000LL,
+             (unsigned)stats.delay_ms, (unsigned)bulk_total);
+#else
+    init_seq_run(init_cmd, legacy_init_write, NULL, &stats);
+    ESP_LOGI(TAG, "Init table: %u commands in %lld us plus %u ms delays",
+             (unsigned)stats.cmds, esp_timer_get_time() - start - stats.delay_ms * 1000LL,
+             (unsigned)stats.delay_ms);
+#endif
 
     esp_lcd_rgb_panel_config_t panel_config = {
         .clk_src = LCD_CLK_SRC_DEFAULT,
@@ -127,7 +274,11 @@ extern "C" void display_init()
         },
         .data_width = 16, // RGB565 in parallel mode, thus 16bit in width
         .bits_per_pixel = 0,
+#if CONFIG_LILYGO_T_RGB_DIRECT_MODE
+        .num_fbs = 2,
+#else
         .num_fbs = 1,
+#endif
         .bounce_buffer_size_px = 10 * AMOLED_WIDTH,
         .sram_trans_align = 64,
         .psram_trans_align = 64,
@@ -171,10 +322,23 @@ extern "C" void display_init()
     };
     ESP_ERROR_CHECK(esp_lcd_new_rgb_panel(&panel_config, &panel_handle));
 
+#if CONFIG_LILYGO_T_RGB_DIRECT_MODE
+    // LVGL uses the two frame buffers as its draw buffers
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_get_frame_buffer(panel_handle, 2, &buf1, &buf2));
+    sem_vsync_end = xSemaphoreCreateBinary();
+    assert(sem_vsync_end);
+    sem_gui_ready = xSemaphoreCreateBinary();
+    assert(sem_gui_ready);
+    esp_lcd_rgb_panel_event_callbacks_t cbs = {};
+    cbs.on_vsync = display_on_vsync;
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_register_event_callbacks(panel_handle, &cbs, NULL));
+#endif
 
 
     ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
+    // Outside direct mode display_push_colors() draws through it
+    panel_flush_attach_lcd(panel_handle);
 
     ESP_LOGI(TAG, "Turn on LCD backlight");
     gpio_config_t bk_gpio_config = {
@@ -215,15 +379,62 @@ void TouchDrvPinMode(uint32_t gpio, uint8_t mode)
     }
 }
 
-extern "C"  bool board_rgb_touch_init()
+static TouchDrvInterface *rgb_touch_begin(TouchDrvInterface *drv, uint8_t address)
 {
-
     const uint8_t touch_reset_pin = tp_reset | 0x80;
     const uint8_t touch_irq_pin = BOARD_TOUCH_IRQ;
 
-    ESP_LOGI(TAG, "=================setupTouchDrv====================");
+    drv->setGpioCallback(TouchDrvPinMode, TouchDrvDigitalWrite, TouchDrvDigitalRead);
+    drv->setPins(touch_reset_pin, touch_irq_pin);
+    if (drv->begin(bus_handle, address)) {
+        return drv;
+    }
+    delete drv;
+    return NULL;
+}
+
+// The touch controller tells the 2.1 inch panel from the 2.8 inch one
+static bool rgb_touch_try(uint8_t address)
+{
+    switch (address) {
+    case CST816_SLAVE_ADDRESS:
+        touchDrv = rgb_touch_begin(new TouchDrvCSTXXX(), address);
+        if (touchDrv) {
+            init_cmd = st7701_2_1_inches;
+            const char *model = touchDrv->getModelName();
+            TouchDrvCSTXXX *drv = static_cast<TouchDrvCSTXXX *>(touchDrv);
+            drv->disableAutoSleep();
+            ESP_LOGI(TAG, "Successfully initialized %s, using %s Driver!", model, model);
+        }
+        break;
+    case FT3267_SLAVE_ADDRESS:
+        touchDrv = rgb_touch_begin(new TouchDrvFT6X36(), address);
+        if (touchDrv) {
+            init_cmd = st7701_2_1_inches;
+            ESP_LOGI(TAG, "Successfully initialized FT63X6, using FT63X6 Driver!");
+        }
+        break;
+    case GT911_SLAVE_ADDRESS_L:
+        touchDrv = rgb_touch_begin(new TouchDrvGT911(), address);
+        if (touchDrv) {
+            init_cmd = st7701_2_8_inches;
+            ESP_LOGI(TAG, "Successfully initialized GT911, using GT911 Driver!");
+        }
+        break;
+    default:
+        touchDrv = NULL;
+        break;
+    }
+    return touchDrv != NULL;
+}
 
-    bool result = false;
+extern "C"  bool board_rgb_touch_init()
+{
+    static const uint8_t models[] = {
+        CST816_SLAVE_ADDRESS, FT3267_SLAVE_ADDRESS, GT911_SLAVE_ADDRESS_L
+    };
+
+    ESP_LOGI(TAG, "=================setupTouchDrv====================");
 
     if (!extension.begin(bus_handle,  XL9555_SLAVE_ADDRESS0)) {
         ESP_LOGE(TAG, "ERROR : XL9555 NO ON LINE!!!");
@@ -236,47 +447,21 @@ extern "C"  bool board_rgb_touch_init()
     extension.pinMode(sdmmc_cs, OUTPUT);
     extension.digitalWrite(sdmmc_cs, HIGH);
 
-    touchDrv = new TouchDrvCSTXXX();
-    touchDrv->setGpioCallback(TouchDrvPinMode, TouchDrvDigitalWrite, TouchDrvDigitalRead);
-    touchDrv->setPins(touch_reset_pin, touch_irq_pin);
-    result = touchDrv->begin(bus_handle, CST816_SLAVE_ADDRESS);
-    if (result) {
-        init_cmd = st7701_2_1_inches;
-        const char *model = touchDrv->getModelName();
-        TouchDrvCSTXXX *drv = static_cast<TouchDrvCSTXXX *>(touchDrv);
-        drv->disableAutoSleep();
-        ESP_LOGI(TAG, "Successfully initialized %s, using %s Driver!", model, model);
+    // Each model that is not fitted costs a reset and its begin() retries,
+    // start with the one that answered last time
+    uint8_t known = i2c_drv_device(I2C_DEV_TOUCH);
+    if (known && rgb_touch_try(known)) {
         return true;
     }
-
-    delete touchDrv;
-
-    touchDrv = new TouchDrvFT6X36();
-    touchDrv->setGpioCallback(TouchDrvPinMode, TouchDrvDigitalWrite, TouchDrvDigitalRead);
-    touchDrv->setPins(touch_reset_pin, touch_irq_pin);
-    result = touchDrv->begin(bus_handle, FT3267_SLAVE_ADDRESS);
-    if (result) {
-        init_cmd = st7701_2_1_inches;
-        ESP_LOGI(TAG, "Successfully initialized FT63X6, using FT63X6 Driver!");
-        return true;
-    }
-
-    delete touchDrv;
-
-    touchDrv = new TouchDrvGT911();
-    touchDrv->setGpioCallback(TouchDrvPinMode, TouchDrvDigitalWrite, TouchDrvDigitalRead);
-    touchDrv->setPins(touch_reset_pin, touch_irq_pin);
-    result = touchDrv->begin(bus_handle, GT911_SLAVE_ADDRESS_L);
-    if (result) {
-        init_cmd = st7701_2_8_inches;
-        ESP_LOGI(TAG, "Successfully initialized GT911, using GT911 Driver!");
-        return true;
+    for (uint8_t address : models) {
+        if (address != known && rgb_touch_try(address)) {
+            i2c_drv_set_device(I2C_DEV_TOUCH, address);
+            return true;
+        }
     }
-    delete touchDrv;
-
-    touchDrv = NULL;
 
     ESP_LOGE(TAG, "Failed initialized TouchDrv!!!!!");
+    i2c_drv_set_device(I2C_DEV_TOUCH, 0);
 
     return false;
 }
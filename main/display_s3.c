@@ -16,6 +16,7 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "product_pins.h"
+#include "panel_flush.h"
 
 #if CONFIG_LILYGO_T_DISPLAY_S3
 
@@ -27,33 +28,36 @@ static const char *TAG = "TFT";
 
 static esp_lcd_panel_io_handle_t io_handle = NULL;
 static esp_lcd_panel_handle_t panel_handle = NULL;
-extern lv_disp_drv_t disp_drv;
-
-lcd_cmd_t lcd_st7789v[] = {
-    {0x11, {0}, 0 | 0x80},
-    {0x3A, {0X05}, 1},
-    {0xB2, {0X0B, 0X0B, 0X00, 0X33, 0X33}, 5},
-    {0xB7, {0X75}, 1},
-    {0xBB, {0X28}, 1},
-    {0xC0, {0X2C}, 1},
-    {0xC2, {0X01}, 1},
-    {0xC3, {0X1F}, 1},
-    {0xC6, {0X13}, 1},
-    {0xD0, {0XA7}, 1},
-    {0xD0, {0XA4, 0XA1}, 2},
-    {0xD6, {0XA1}, 1},
-    {0xE0, {0XF0, 0X05, 0X0A, 0X06, 0X06, 0X03, 0X2B, 0X32, 0X43, 0X36, 0X11, 0X10, 0X2B, 0X32}, 14},
-    {0xE1, {0XF0, 0X08, 0X0C, 0X0B, 0X09, 0X24, 0X2B, 0X22, 0X43, 0X38, 0X15, 0X16, 0X2F, 0X37}, 14},
+extern void display_flush_ready(void);
+
+static const uint8_t lcd_st7789v[] = {
+    INIT_CMD0_DELAY(0x11, 120),
+    INIT_CMD(0x3A, 0X05),
+    INIT_CMD(0xB2, 0X0B, 0X0B, 0X00, 0X33, 0X33),
+    INIT_CMD(0xB7, 0X75),
+    INIT_CMD(0xBB, 0X28),
+    INIT_CMD(0xC0, 0X2C),
+    INIT_CMD(0xC2, 0X01),
+    INIT_CMD(0xC3, 0X1F),
+    INIT_CMD(0xC6, 0X13),
+    INIT_CMD(0xD0, 0XA7),
+    INIT_CMD(0xD0, 0XA4, 0XA1),
+    INIT_CMD(0xD6, 0XA1),
+    INIT_CMD(0xE0, 0XF0, 0X05, 0X0A, 0X06, 0X06, 0X03, 0X2B, 0X32, 0X43, 0X36, 0X11, 0X10, 0X2B, 0X32),
+    INIT_CMD(0xE1, 0XF0, 0X08, 0X0C, 0X0B, 0X09, 0X24, 0X2B, 0X22, 0X43, 0X38, 0X15, 0X16, 0X2F, 0X37),
+    INIT_SEQ_END
 };
 
-void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+// esp_lcd queues the command on the i80 bus and waits for it, so there is
+// nothing to sync before the delays
+static void display_init_write(uint8_t cmd, const uint8_t *param, uint8_t len)
 {
-    esp_lcd_panel_draw_bitmap(panel_handle, x, y, width, hight, data);
+    esp_lcd_panel_io_tx_param(io_handle, cmd, len ? param : NULL, len);
 }
 
 bool display_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
-    lv_disp_flush_ready(&disp_drv);
+    display_flush_ready();
     return false;
 }
 
@@ -122,25 +126,10 @@ void display_init()
 
     esp_lcd_panel_init(panel_handle);
 
-    esp_lcd_panel_invert_color(panel_handle, true);
+    // Inversion, orientation and gap of the board, see panel_traits.hpp
+    panel_flush_attach_lcd(panel_handle);
 
-    esp_lcd_panel_swap_xy(panel_handle, true);
-
-    //The screen faces you, and the USB is on the left
-    esp_lcd_panel_mirror(panel_handle, false, true);
-
-    //The screen faces you, the USB is to the right
-    // esp_lcd_panel_mirror(panel_handle, true, false);
-
-    // the gap is LCD panel specific, even panels with the same driver IC, can
-    // have different gap value
-    esp_lcd_panel_set_gap(panel_handle, 0, 35);
-
-    for (uint8_t i = 0; i < (sizeof(lcd_st7789v) / sizeof(lcd_cmd_t)); i++) {
-        esp_lcd_panel_io_tx_param(io_handle, lcd_st7789v[i].addr, lcd_st7789v[i].param, lcd_st7789v[i].len & 0x7f);
-        if (lcd_st7789v[i].len & 0x80)
-            vTaskDelay(pdMS_TO_TICKS(120));
-    }
+    init_seq_run(lcd_st7789v, display_init_write, NULL, NULL);
 
     esp_lcd_panel_disp_on_off(panel_handle, true);
 
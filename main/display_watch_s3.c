@@ -15,6 +15,7 @@
 #include "esp_log.h"
 #include "esp_idf_version.h"
 #include "driver/spi_master.h"
+#include "panel_flush.h"
 
 #if CONFIG_LILYGO_T_WATCH_S3 || CONFIG_LILYGO_T_WATCH_2019
 
@@ -27,16 +28,11 @@
 static const char *TAG = "TFT";
 static esp_lcd_panel_io_handle_t io_handle = NULL;
 static esp_lcd_panel_handle_t panel_handle = NULL;
-extern lv_disp_drv_t disp_drv;
-
-void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
-{
-    esp_lcd_panel_draw_bitmap(panel_handle, x, y, width, hight, data);
-}
+extern void display_flush_ready(void);
 
 bool display_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
-    lv_disp_flush_ready(&disp_drv);
+    display_flush_ready();
     return false;
 }
 
@@ -79,10 +75,8 @@ void display_init()
     ESP_ERROR_CHECK(esp_lcd_new_panel_st7789(io_handle, &panel_config, &panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
-    ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel_handle, true));
-    esp_lcd_panel_swap_xy(panel_handle, false);
-    ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, true, false));
-    esp_lcd_panel_set_gap(panel_handle, 0, 0);
+    // Inversion, orientation and gap of the board, see panel_traits.hpp
+    panel_flush_attach_lcd(panel_handle);
     ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
 
     ESP_LOGI(TAG, "Turn on LCD backlight");
@@ -13,22 +13,71 @@
 #include "freertos/task.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "nvs.h"
 #include "sdkconfig.h"
 #include "product_pins.h"
 #include "driver/i2c_master.h"
 #include "soc/clk_tree_defs.h"
+#include "i2c_sched.h"
+#include "i2c_driver.h"
 
 #ifdef BOARD_I2C_SDA
 
+static const char *TAG = "I2C";
+
 
 #define I2C_MASTER_NUM              I2C_NUM_0
 #define I2C_MASTER_FREQ_HZ          400000      /*!< I2C master clock frequency */
 #define I2C_MASTER_SDA_IO           (gpio_num_t) BOARD_I2C_SDA
 #define I2C_MASTER_SCL_IO           (gpio_num_t) BOARD_I2C_SCL
+// An absent device NACKs its address right away, only a stuck bus needs more
+#define I2C_PROBE_TIMEOUT_MS        10
+
+// The topology is stored per board, a module moved to another board must
+// not pick up the devices of the previous one
+#if defined(CONFIG_LILYGO_T_AMOLED_LITE_147)
+#define I2C_TOPOLOGY_KEY            "amoled_lite"
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED)
+#define I2C_TOPOLOGY_KEY            "s3_amoled"
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED_TOUCH)
+#define I2C_TOPOLOGY_KEY            "s3_amoled_tp"
+#elif defined(CONFIG_LILYGO_T4_S3_241)
+#define I2C_TOPOLOGY_KEY            "t4_s3"
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3)
+#define I2C_TOPOLOGY_KEY            "s3"
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3_PRO)
+#define I2C_TOPOLOGY_KEY            "s3_pro"
+#elif defined(CONFIG_LILYGO_T_DISPLAY_LONG)
+#define I2C_TOPOLOGY_KEY            "long"
+#elif defined(CONFIG_LILYGO_T_QT_C6)
+#define I2C_TOPOLOGY_KEY            "qt_c6"
+#elif defined(CONFIG_LILYGO_T_RGB)
+#define I2C_TOPOLOGY_KEY            "rgb"
+#elif defined(CONFIG_LILYGO_T_WATCH_S3)
+#define I2C_TOPOLOGY_KEY            "watch_s3"
+#elif defined(CONFIG_LILYGO_T_WATCH_2019)
+#define I2C_TOPOLOGY_KEY            "watch_2019"
+#else
+#define I2C_TOPOLOGY_KEY            "board"
+#endif
+#define I2C_TOPOLOGY_NAMESPACE      "i2c_topo"
+// Bump when the layout of i2c_topology_t or the known addresses change
+#define I2C_TOPOLOGY_VERSION        1
 
 i2c_master_bus_handle_t bus_handle;
 
+// Probes wait behind touch and PMU traffic
+static esp_err_t i2c_drv_probe_scheduled(void *arg)
+{
+    return i2c_master_probe(bus_handle, *(uint8_t *)arg, I2C_PROBE_TIMEOUT_MS);
+}
 
+static esp_err_t i2c_drv_probe_address(uint8_t address)
+{
+    return i2c_sched_run(I2C_SCHED_PRIO_DIAG, i2c_drv_probe_scheduled, &address, 100);
+}
 
 void i2c_drv_scan()
 {
@@ -41,7 +90,7 @@ void i2c_drv_scan()
         for (int j = 0; j < 16; j++) {
             fflush(stdout);
             address = i + j;
-            err = i2c_master_probe(bus_handle, address, 1000);
+            err = i2c_drv_probe_address(address);
             if (err == ESP_OK) {
                 printf("%02x ", address);
             } else if (err == ESP_ERR_TIMEOUT) {
@@ -57,9 +106,198 @@ void i2c_drv_scan()
 
 bool i2c_drv_probe(uint8_t devAddr)
 {
-    return ESP_OK == i2c_master_probe(bus_handle, devAddr, 1000);
+    return ESP_OK == i2c_drv_probe_address(devAddr);
+}
+
+typedef struct {
+    uint8_t version;
+    uint8_t address[I2C_DEV_CLASS_MAX];
+} i2c_topology_t;
+
+// Every address a device of the class may answer on, in probe order
+static const uint8_t pmu_addresses[] = {
+    0x34,       // AXP2101
+    0x35,       // AXP202
+    0x6A,       // SY6970
+};
+static const uint8_t touch_addresses[] = {
+    0x15,       // CST816 / CST820
+    0x5A,       // CST226SE
+    0x2E,       // CHSC5816
+    0x38,       // FT3267 / FT6X36
+    0x5D,       // GT911
+    0x14,       // GT911, alternate address
+    0x3B,       // AXS15231B, T-Display-Long
+};
+static const uint8_t expander_addresses[] = {
+    0x20,       // XL9555
+};
+static const uint8_t light_addresses[] = {
+    0x23,       // LTR553
+};
+static const uint8_t rtc_addresses[] = {
+    0x51,       // PCF8563
+};
+
+static const struct {
+    const uint8_t *addresses;
+    uint8_t count;
+} known_devices[I2C_DEV_CLASS_MAX] = {
+    [I2C_DEV_PMU]       = {pmu_addresses, sizeof(pmu_addresses)},
+    [I2C_DEV_TOUCH]     = {touch_addresses, sizeof(touch_addresses)},
+    [I2C_DEV_EXPANDER]  = {expander_addresses, sizeof(expander_addresses)},
+    [I2C_DEV_LIGHT]     = {light_addresses, sizeof(light_addresses)},
+    [I2C_DEV_RTC]       = {rtc_addresses, sizeof(rtc_addresses)},
+};
+
+static const char *const class_names[I2C_DEV_CLASS_MAX] = {
+    "pmu", "touch", "expander", "light", "rtc"
+};
+
+static i2c_topology_t topology;
+static bool discovered = false;
+// Classes a driver has reported through i2c_drv_set_device()
+static uint32_t reported = 0;
+
+static esp_err_t i2c_topology_open(nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    // Does nothing when the Wi-Fi scanner or anyone else got here first
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return nvs_open(I2C_TOPOLOGY_NAMESPACE, mode, handle);
+}
+
+static bool i2c_topology_load(void)
+{
+    nvs_handle_t handle;
+    if (i2c_topology_open(NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    i2c_topology_t stored;
+    size_t size = sizeof(stored);
+    esp_err_t ret = nvs_get_blob(handle, I2C_TOPOLOGY_KEY, &stored, &size);
+    nvs_close(handle);
+    if (ret != ESP_OK || size != sizeof(stored) || stored.version != I2C_TOPOLOGY_VERSION) {
+        return false;
+    }
+    topology = stored;
+    return true;
+}
+
+static void i2c_topology_save(void)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = i2c_topology_open(NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, I2C_TOPOLOGY_KEY, &topology, sizeof(topology));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Topology not stored: %s", esp_err_to_name(ret));
+    }
+}
+
+// One pass over the known addresses, the first one answering per class wins
+static esp_err_t i2c_topology_probe(void *arg)
+{
+    for (int i = 0; i < I2C_DEV_CLASS_MAX; i++) {
+        topology.address[i] = 0;
+        for (int j = 0; j < known_devices[i].count; j++) {
+            uint8_t address = known_devices[i].addresses[j];
+            if (i2c_master_probe(bus_handle, address, I2C_PROBE_TIMEOUT_MS) == ESP_OK) {
+                topology.address[i] = address;
+                break;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+// Put back what the drivers reported, true when that differs from topology
+static bool i2c_topology_apply_reported(const i2c_topology_t *from_drivers)
+{
+    bool changed = false;
+    for (int i = 0; i < I2C_DEV_CLASS_MAX; i++) {
+        if ((reported & (1 << i)) && topology.address[i] != from_drivers->address[i]) {
+            topology.address[i] = from_drivers->address[i];
+            changed = true;
+        }
+    }
+    return changed;
 }
 
+void i2c_drv_discover(void)
+{
+    int64_t start = esp_timer_get_time();
+    i2c_topology_t from_drivers = topology;
+    bool cached = i2c_topology_load();
+    if (!cached) {
+        topology.version = I2C_TOPOLOGY_VERSION;
+        esp_err_t ret = i2c_sched_run(I2C_SCHED_PRIO_DIAG, i2c_topology_probe, NULL, 1000);
+        if (ret != ESP_OK) {
+            // Nothing is stored, the next boot probes again. Until then only
+            // what the drivers found themselves is known.
+            ESP_LOGE(TAG, "Discovery failed: %s", esp_err_to_name(ret));
+            memset(topology.address, 0, sizeof(topology.address));
+            i2c_topology_apply_reported(&from_drivers);
+            return;
+        }
+    }
+    bool changed = i2c_topology_apply_reported(&from_drivers);
+    discovered = true;
+    if (!cached || changed) {
+        i2c_topology_save();
+    }
+    ESP_LOGI(TAG, "Topology %s in %lu us:", cached ? "from NVS" : "probed",
+             (unsigned long)(esp_timer_get_time() - start));
+    for (int i = 0; i < I2C_DEV_CLASS_MAX; i++) {
+        if (topology.address[i]) {
+            ESP_LOGI(TAG, "  %-8s 0x%02x", class_names[i], topology.address[i]);
+        }
+    }
+}
+
+uint8_t i2c_drv_device(i2c_dev_class_t cls)
+{
+    return cls < I2C_DEV_CLASS_MAX ? topology.address[cls] : 0;
+}
+
+void i2c_drv_set_device(i2c_dev_class_t cls, uint8_t address)
+{
+    if (cls >= I2C_DEV_CLASS_MAX) {
+        return;
+    }
+    reported |= 1 << cls;
+    if (topology.address[cls] == address) {
+        return;
+    }
+    topology.address[cls] = address;
+    if (discovered) {
+        i2c_topology_save();
+    }
+}
+
+void i2c_drv_forget_topology(void)
+{
+    nvs_handle_t handle;
+    if (i2c_topology_open(NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_erase_key(handle, I2C_TOPOLOGY_KEY) == ESP_OK) {
+        nvs_commit(handle);
+        ESP_LOGW(TAG, "Topology dropped, probing again on the next boot");
+    }
+    nvs_close(handle);
+}
 
 /**
  * @brief i2c master initialization
@@ -73,7 +311,12 @@ esp_err_t i2c_driver_init(void)
     i2c_bus_config.scl_io_num = I2C_MASTER_SCL_IO;
     i2c_bus_config.sda_io_num = I2C_MASTER_SDA_IO;
     i2c_bus_config.glitch_ignore_cnt = 7;
-    return i2c_new_master_bus(&i2c_bus_config, &bus_handle);
+    esp_err_t ret = i2c_new_master_bus(&i2c_bus_config, &bus_handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    // From here on the scheduler task owns the bus
+    return i2c_sched_init(bus_handle);
 }
 
 #else
@@ -82,4 +325,21 @@ esp_err_t i2c_driver_init(void)
 {
     return ESP_OK;
 }
+
+void i2c_drv_discover(void)
+{
+}
+
+uint8_t i2c_drv_device(i2c_dev_class_t cls)
+{
+    return 0;
+}
+
+void i2c_drv_set_device(i2c_dev_class_t cls, uint8_t address)
+{
+}
+
+void i2c_drv_forget_topology(void)
+{
+}
 #endif
\ No newline at end of file
@@ -17,6 +17,37 @@ extern "C" {
 esp_err_t i2c_driver_init(void);
 void i2c_drv_scan();
 
+// Kinds of devices whose address the drivers look up instead of probing
+typedef enum {
+    I2C_DEV_PMU,
+    I2C_DEV_TOUCH,
+    I2C_DEV_EXPANDER,
+    I2C_DEV_LIGHT,
+    I2C_DEV_RTC,
+    I2C_DEV_CLASS_MAX,
+} i2c_dev_class_t;
+
+/**
+ * @brief Find the known devices on the bus
+ *
+ * The first boot of a board probes the addresses of every known device once
+ * with a short timeout and stores what answered in NVS, later boots load
+ * that instead of touching the bus. Call it once the PMU has powered its
+ * rails, what a driver reported before through i2c_drv_set_device() wins
+ * over the stored and probed addresses.
+ */
+void i2c_drv_discover(void);
+
+// Address that answered for the class, 0 when none did
+uint8_t i2c_drv_device(i2c_dev_class_t cls);
+
+// Record what a driver found itself, e.g. a controller that only answers
+// after its reset. Before i2c_drv_discover() this is only kept in memory.
+void i2c_drv_set_device(i2c_dev_class_t cls, uint8_t address);
+
+// Drop the stored topology, the next boot probes again
+void i2c_drv_forget_topology(void);
+
 extern i2c_master_bus_handle_t bus_handle;
 #ifdef __cplusplus
 }
@@ -10,465 +10,465 @@
 #include "initSequence.h"
 
 
-const lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGHT] = {
+const uint8_t sh8501_cmd[] = {
 
     // ===  CMD2 password  ===
-    {0xfe00, {0x20}, 0x01},
-    {0xf400, {0x5a}, 0x01},
-    {0xf500, {0x59}, 0x01},
+    INIT_CMD(0xfe, 0x20),
+    INIT_CMD(0xf4, 0x5a),
+    INIT_CMD(0xf5, 0x59),
 
     // ===  ID code  ===
-    {0xfe00, {0x40}, 0x01},
-    {0xd800, {0x33}, 0x01},
-    {0xd900, {0x06}, 0x01},
-    {0xda00, {0x00}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0xd8, 0x33),
+    INIT_CMD(0xd9, 0x06),
+    INIT_CMD(0xda, 0x00),
 
     // ===  QSPI setting  ===
-    {0xfe00, {0x20}, 0x01},
-    {0x1a00, {0x15}, 0x01},
-    {0x1900, {0x10}, 0x01},
-    {0x1c00, {0xa0}, 0x01},
+    INIT_CMD(0xfe, 0x20),
+    INIT_CMD(0x1a, 0x15),
+    INIT_CMD(0x19, 0x10),
+    INIT_CMD(0x1c, 0xa0),
 
     // ===  Timing Gen  ===
-    {0xfe00, {0x40}, 0x01},
-    {0x0100, {0x90}, 0x01},
-    {0x0200, {0x5c}, 0x01},
-    {0x5900, {0x01}, 0x01},
-    {0x5a00, {0x58}, 0x01},
-    {0x5b00, {0x08}, 0x01},
-    {0x5c00, {0x08}, 0x01},
-    {0x7000, {0x01}, 0x01},
-    {0x7100, {0x58}, 0x01},
-    {0x7200, {0x08}, 0x01},
-    {0x7300, {0x08}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x01, 0x90),
+    INIT_CMD(0x02, 0x5c),
+    INIT_CMD(0x59, 0x01),
+    INIT_CMD(0x5a, 0x58),
+    INIT_CMD(0x5b, 0x08),
+    INIT_CMD(0x5c, 0x08),
+    INIT_CMD(0x70, 0x01),
+    INIT_CMD(0x71, 0x58),
+    INIT_CMD(0x72, 0x08),
+    INIT_CMD(0x73, 0x08),
 
     // ===  AOD setting===
-    {0xfe00, {0x40}, 0x01},
-    {0x5d00, {0x24}, 0x01},
-    {0x6000, {0x08}, 0x01},
-    {0x6100, {0x04}, 0x01},
-    {0x6200, {0x7f}, 0x01},
-    {0x6900, {0x06}, 0x01},
-    {0x0c00, {0xd7}, 0x01},
-    {0x0d00, {0xfc}, 0x01},
-    {0x3900, {0x24}, 0x01},
-    {0x3d00, {0x08}, 0x01},
-    {0x4700, {0x06}, 0x01},
-    {0x6d00, {0x04}, 0x01},
-    {0x1000, {0x11}, 0x01},
-    {0x1100, {0x09}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x5d, 0x24),
+    INIT_CMD(0x60, 0x08),
+    INIT_CMD(0x61, 0x04),
+    INIT_CMD(0x62, 0x7f),
+    INIT_CMD(0x69, 0x06),
+    INIT_CMD(0x0c, 0xd7),
+    INIT_CMD(0x0d, 0xfc),
+    INIT_CMD(0x39, 0x24),
+    INIT_CMD(0x3d, 0x08),
+    INIT_CMD(0x47, 0x06),
+    INIT_CMD(0x6d, 0x04),
+    INIT_CMD(0x10, 0x11),
+    INIT_CMD(0x11, 0x09),
 
     // ===  Power Settings  ===
-    {0xfe00, {0xe0}, 0x01},
-    {0x0000, {0x14}, 0x01},
-    {0x0100, {0x01}, 0x01},
-    {0x0200, {0x00}, 0x01}, //{0x0200,{0x00},0x01},
-    {0x0400, {0x04}, 0x01},
-    {0x0600, {0x0f}, 0x01},
-    {0x0800, {0x00}, 0x01},
-    {0x0900, {0x14}, 0x01},
-    {0x0a00, {0x01}, 0x01},
-    {0x0b00, {0x00}, 0x01}, //{0x0b00,{0x00},0x01},
-    {0x0c00, {0x04}, 0x01},
-    {0x0e00, {0x0f}, 0x01},
-    {0x0f00, {0x00}, 0x01},
-    {0x1000, {0x14}, 0x01},
-    {0x1100, {0x10}, 0x01},
-    {0x2400, {0x00}, 0x01},
-    {0x2100, {0x99}, 0x01},
-    {0x2d00, {0x99}, 0x01},
-    {0x3200, {0x99}, 0x01},
-    {0x2600, {0x41}, 0x01},
-    {0x2200, {0x1a}, 0x01},
-    {0x2300, {0x13}, 0x01},
-    {0x3000, {0x01}, 0x01},
-    {0xfe00, {0x40}, 0x01},
-    {0x5700, {0x43}, 0x01}, //{0x5700,{0x43},0x01},
-    {0x5800, {0x33}, 0x01},
-    {0x6e00, {0x43}, 0x01}, //{0x6e00,{0x43},0x01},
-    {0x6f00, {0x33}, 0x01},
-    {0x7400, {0x43}, 0x01}, //{0x7400,{0x43},0x01},
-    {0x7500, {0x33}, 0x01},
+    INIT_CMD(0xfe, 0xe0),
+    INIT_CMD(0x00, 0x14),
+    INIT_CMD(0x01, 0x01),
+    INIT_CMD(0x02, 0x00), //INIT_CMD(0x02, 0x00),
+    INIT_CMD(0x04, 0x04),
+    INIT_CMD(0x06, 0x0f),
+    INIT_CMD(0x08, 0x00),
+    INIT_CMD(0x09, 0x14),
+    INIT_CMD(0x0a, 0x01),
+    INIT_CMD(0x0b, 0x00), //INIT_CMD(0x0b, 0x00),
+    INIT_CMD(0x0c, 0x04),
+    INIT_CMD(0x0e, 0x0f),
+    INIT_CMD(0x0f, 0x00),
+    INIT_CMD(0x10, 0x14),
+    INIT_CMD(0x11, 0x10),
+    INIT_CMD(0x24, 0x00),
+    INIT_CMD(0x21, 0x99),
+    INIT_CMD(0x2d, 0x99),
+    INIT_CMD(0x32, 0x99),
+    INIT_CMD(0x26, 0x41),
+    INIT_CMD(0x22, 0x1a),
+    INIT_CMD(0x23, 0x13),
+    INIT_CMD(0x30, 0x01),
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x57, 0x43), //INIT_CMD(0x57, 0x43),
+    INIT_CMD(0x58, 0x33),
+    INIT_CMD(0x6e, 0x43), //INIT_CMD(0x6e, 0x43),
+    INIT_CMD(0x6f, 0x33),
+    INIT_CMD(0x74, 0x43), //INIT_CMD(0x74, 0x43),
+    INIT_CMD(0x75, 0x33),
 
     // // ===  swire setting for RT4722 ===
-    // {0xfe00,{0x40},0x01},
-    // {0x1200,{0xfe},0x01},
-    // {0x1300,{0x08},0x01},
-    // {0xc900,{0x21},0x01},
-    // {0x9600,{0x00},0x01},
-    // {0x9700,{0x02},0x01},
-    // {0xa500,{0xff},0x01},//{0xa500,{0xff},0x01},
-    // {0xaa00,{0x21},0x01},//{0xaa00,{0x21},0x01},
-    // {0xab00,{0x00},0x01},//{0xab00,{0x00},0x01},
-    // {0x9800,{0x00},0x01},
-    // {0xa700,{0x21},0x01},
-    // {0xa900,{0x00},0x01},
+    // INIT_CMD(0xfe, 0x40),
+    // INIT_CMD(0x12, 0xfe),
+    // INIT_CMD(0x13, 0x08),
+    // INIT_CMD(0xc9, 0x21),
+    // INIT_CMD(0x96, 0x00),
+    // INIT_CMD(0x97, 0x02),
+    // INIT_CMD(0xa5, 0xff),//INIT_CMD(0xa5, 0xff),
+    // INIT_CMD(0xaa, 0x21),//INIT_CMD(0xaa, 0x21),
+    // INIT_CMD(0xab, 0x00),//INIT_CMD(0xab, 0x00),
+    // INIT_CMD(0x98, 0x00),
+    // INIT_CMD(0xa7, 0x21),
+    // INIT_CMD(0xa9, 0x00),
 
     // ===  swire setting for BV6802 ===
-    {0xfe00, {0x40}, 0x01},
-    {0x1200, {0xfe}, 0x01},
-    {0x1300, {0x08}, 0x01},
-    {0xc900, {0x5f}, 0x01},
-    {0x9600, {0x38}, 0x01},
-    {0x9700, {0x02}, 0x01},
-    {0xa500, {0xff}, 0x01},
-    {0xaa00, {0x38}, 0x01},
-    {0xab00, {0x5f}, 0x01},
-    {0x9800, {0x00}, 0x01},
-    {0xa700, {0x38}, 0x01},
-    {0xa900, {0x5f}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x12, 0xfe),
+    INIT_CMD(0x13, 0x08),
+    INIT_CMD(0xc9, 0x5f),
+    INIT_CMD(0x96, 0x38),
+    INIT_CMD(0x97, 0x02),
+    INIT_CMD(0xa5, 0xff),
+    INIT_CMD(0xaa, 0x38),
+    INIT_CMD(0xab, 0x5f),
+    INIT_CMD(0x98, 0x00),
+    INIT_CMD(0xa7, 0x38),
+    INIT_CMD(0xa9, 0x5f),
 
     //=== GOA mapping ===
-    {0xfe00, {0x70}, 0x01},
-    {0x9b00, {0x02}, 0x01},
-    {0x9c00, {0x03}, 0x01},
-    {0x9d00, {0x08}, 0x01},
-    {0x9e00, {0x19}, 0x01},
-    {0x9f00, {0x19}, 0x01},
-    {0xa000, {0x19}, 0x01},
-    {0xa200, {0x19}, 0x01},
-    {0xa300, {0x19}, 0x01},
-    {0xa400, {0x19}, 0x01},
-    {0xa500, {0x19}, 0x01},
-    {0xa600, {0x11}, 0x01},
-    {0xa700, {0x10}, 0x01},
-    {0xa900, {0x0f}, 0x01},
-    {0xaa00, {0x19}, 0x01},
-    {0xab00, {0x19}, 0x01},
-    {0xac00, {0x19}, 0x01},
-    {0xad00, {0x19}, 0x01},
-    {0xae00, {0x19}, 0x01},
-    {0xaf00, {0x19}, 0x01},
-    {0xb000, {0x19}, 0x01},
-    {0xb100, {0x19}, 0x01},
-    {0xb200, {0x19}, 0x01},
-    {0xb300, {0x19}, 0x01},
-    {0xb400, {0x19}, 0x01},
-    {0xb500, {0x19}, 0x01},
-    {0xb600, {0x19}, 0x01},
-    {0xb700, {0x19}, 0x01},
-    {0xb800, {0x00}, 0x01},
-    {0xb900, {0x01}, 0x01},
-    {0xba00, {0x09}, 0x01},
-    {0xbb00, {0x19}, 0x01},
-    {0xbc00, {0x19}, 0x01},
-    {0xbd00, {0xf9}, 0x01},
-    {0xbe00, {0x19}, 0x01},
-    {0xbf00, {0x19}, 0x01},
-    {0xc000, {0x0e}, 0x01},
-    {0xc100, {0x0d}, 0x01},
-    {0xc200, {0x0c}, 0x01},
-    {0xc300, {0x19}, 0x01},
-    {0xc400, {0x19}, 0x01},
-    {0xc500, {0x19}, 0x01},
-    {0xc600, {0x19}, 0x01},
-    {0xc700, {0x19}, 0x01},
-    {0xc800, {0x19}, 0x01},
+    INIT_CMD(0xfe, 0x70),
+    INIT_CMD(0x9b, 0x02),
+    INIT_CMD(0x9c, 0x03),
+    INIT_CMD(0x9d, 0x08),
+    INIT_CMD(0x9e, 0x19),
+    INIT_CMD(0x9f, 0x19),
+    INIT_CMD(0xa0, 0x19),
+    INIT_CMD(0xa2, 0x19),
+    INIT_CMD(0xa3, 0x19),
+    INIT_CMD(0xa4, 0x19),
+    INIT_CMD(0xa5, 0x19),
+    INIT_CMD(0xa6, 0x11),
+    INIT_CMD(0xa7, 0x10),
+    INIT_CMD(0xa9, 0x0f),
+    INIT_CMD(0xaa, 0x19),
+    INIT_CMD(0xab, 0x19),
+    INIT_CMD(0xac, 0x19),
+    INIT_CMD(0xad, 0x19),
+    INIT_CMD(0xae, 0x19),
+    INIT_CMD(0xaf, 0x19),
+    INIT_CMD(0xb0, 0x19),
+    INIT_CMD(0xb1, 0x19),
+    INIT_CMD(0xb2, 0x19),
+    INIT_CMD(0xb3, 0x19),
+    INIT_CMD(0xb4, 0x19),
+    INIT_CMD(0xb5, 0x19),
+    INIT_CMD(0xb6, 0x19),
+    INIT_CMD(0xb7, 0x19),
+    INIT_CMD(0xb8, 0x00),
+    INIT_CMD(0xb9, 0x01),
+    INIT_CMD(0xba, 0x09),
+    INIT_CMD(0xbb, 0x19),
+    INIT_CMD(0xbc, 0x19),
+    INIT_CMD(0xbd, 0xf9),
+    INIT_CMD(0xbe, 0x19),
+    INIT_CMD(0xbf, 0x19),
+    INIT_CMD(0xc0, 0x0e),
+    INIT_CMD(0xc1, 0x0d),
+    INIT_CMD(0xc2, 0x0c),
+    INIT_CMD(0xc3, 0x19),
+    INIT_CMD(0xc4, 0x19),
+    INIT_CMD(0xc5, 0x19),
+    INIT_CMD(0xc6, 0x19),
+    INIT_CMD(0xc7, 0x19),
+    INIT_CMD(0xc8, 0x19),
 
     // ===  source/mux sequence ===
-    {0xfe00, {0x40}, 0x01},
-    {0x4c00, {0x22}, 0x01},
-    {0x5300, {0xa0}, 0x01},
-    {0x0800, {0x0a}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x4c, 0x22),
+    INIT_CMD(0x53, 0xa0),
+    INIT_CMD(0x08, 0x0a),
 
     // ===  SD/SW_Toggle_Sequence_Control ===
-    {0xfe00, {0xf0}, 0x01},
-    {0x7200, {0x33}, 0x01},
-    {0x7300, {0x66}, 0x01},
-    {0x7400, {0x22}, 0x01},
-    {0x7500, {0x55}, 0x01},
-    {0x7600, {0x11}, 0x01},
-    {0x7700, {0x44}, 0x01},
-    {0x7800, {0x33}, 0x01},
-    {0x7900, {0x66}, 0x01},
-    {0x7a00, {0x22}, 0x01},
-    {0x7b00, {0x55}, 0x01},
-    {0x7c00, {0x11}, 0x01},
-    {0x7d00, {0x44}, 0x01},
-    {0x7e00, {0x66}, 0x01},
-    {0x7f00, {0x33}, 0x01},
-    {0x8000, {0x55}, 0x01},
-    {0x8100, {0x22}, 0x01},
-    {0x8200, {0x44}, 0x01},
-    {0x8300, {0x11}, 0x01},
-    {0x8400, {0x66}, 0x01},
-    {0x8500, {0x33}, 0x01},
-    {0x8600, {0x55}, 0x01},
-    {0x8700, {0x22}, 0x01},
-    {0x8800, {0x44}, 0x01},
-    {0x8900, {0x11}, 0x01},
+    INIT_CMD(0xfe, 0xf0),
+    INIT_CMD(0x72, 0x33),
+    INIT_CMD(0x73, 0x66),
+    INIT_CMD(0x74, 0x22),
+    INIT_CMD(0x75, 0x55),
+    INIT_CMD(0x76, 0x11),
+    INIT_CMD(0x77, 0x44),
+    INIT_CMD(0x78, 0x33),
+    INIT_CMD(0x79, 0x66),
+    INIT_CMD(0x7a, 0x22),
+    INIT_CMD(0x7b, 0x55),
+    INIT_CMD(0x7c, 0x11),
+    INIT_CMD(0x7d, 0x44),
+    INIT_CMD(0x7e, 0x66),
+    INIT_CMD(0x7f, 0x33),
+    INIT_CMD(0x80, 0x55),
+    INIT_CMD(0x81, 0x22),
+    INIT_CMD(0x82, 0x44),
+    INIT_CMD(0x83, 0x11),
+    INIT_CMD(0x84, 0x66),
+    INIT_CMD(0x85, 0x33),
+    INIT_CMD(0x86, 0x55),
+    INIT_CMD(0x87, 0x22),
+    INIT_CMD(0x88, 0x44),
+    INIT_CMD(0x89, 0x11),
 
     // === GIP Setting  ===
-    {0xfe00, {0x70}, 0x01},
-    {0x0000, {0xc0}, 0x01},
-    {0x0100, {0x08}, 0x01},
-    {0x0200, {0x02}, 0x01},
-    {0x0300, {0x00}, 0x01},
-    {0x0400, {0x00}, 0x01},
-    {0x0500, {0x01}, 0x01},
-    {0x0600, {0x28}, 0x01},
-    {0x0700, {0x28}, 0x01},
-    {0x0900, {0xc0}, 0x01},
-    {0x0a00, {0x08}, 0x01},
-    {0x0b00, {0x02}, 0x01},
-    {0x0c00, {0x00}, 0x01},
-    {0x0d00, {0x00}, 0x01},
-    {0x0e00, {0x00}, 0x01},
-    {0x0f00, {0x28}, 0x01},
-    {0x1000, {0x28}, 0x01},
-    {0x1200, {0xc0}, 0x01},
-    {0x1300, {0x08}, 0x01},
-    {0x1400, {0x02}, 0x01},
-    {0x1500, {0x00}, 0x01},
-    {0x1600, {0x00}, 0x01},
-    {0x1700, {0x01}, 0x01},
-    {0x1800, {0xd8}, 0x01},
-    {0x1900, {0x18}, 0x01},
-    {0x1b00, {0xc0}, 0x01},
-    {0x1c00, {0x08}, 0x01},
-    {0x1d00, {0x02}, 0x01},
-    {0x1e00, {0x00}, 0x01},
-    {0x1f00, {0x00}, 0x01},
-    {0x2000, {0x00}, 0x01},
-    {0x2100, {0xd8}, 0x01},
-    {0x2200, {0x18}, 0x01},
-    {0x4c00, {0x80}, 0x01},
-    {0x4d00, {0x00}, 0x01},
-    {0x4e00, {0x01}, 0x01},
-    {0x4f00, {0x00}, 0x01},
-    {0x5000, {0x01}, 0x01},
-    {0x5100, {0x01}, 0x01},
-    {0x5200, {0x01}, 0x01},
-    {0x5300, {0xc6}, 0x01},
-    {0x5400, {0x00}, 0x01},
-    {0x5500, {0x03}, 0x01},
-    {0x5600, {0x28}, 0x01},
-    {0x5800, {0x28}, 0x01},
-    {0x6500, {0x80}, 0x01},
-    {0x6600, {0x05}, 0x01},
-    {0x6700, {0x10}, 0x01},
+    INIT_CMD(0xfe, 0x70),
+    INIT_CMD(0x00, 0xc0),
+    INIT_CMD(0x01, 0x08),
+    INIT_CMD(0x02, 0x02),
+    INIT_CMD(0x03, 0x00),
+    INIT_CMD(0x04, 0x00),
+    INIT_CMD(0x05, 0x01),
+    INIT_CMD(0x06, 0x28),
+    INIT_CMD(0x07, 0x28),
+    INIT_CMD(0x09, 0xc0),
+    INIT_CMD(0x0a, 0x08),
+    INIT_CMD(0x0b, 0x02),
+    INIT_CMD(0x0c, 0x00),
+    INIT_CMD(0x0d, 0x00),
+    INIT_CMD(0x0e, 0x00),
+    INIT_CMD(0x0f, 0x28),
+    INIT_CMD(0x10, 0x28),
+    INIT_CMD(0x12, 0xc0),
+    INIT_CMD(0x13, 0x08),
+    INIT_CMD(0x14, 0x02),
+    INIT_CMD(0x15, 0x00),
+    INIT_CMD(0x16, 0x00),
+    INIT_CMD(0x17, 0x01),
+    INIT_CMD(0x18, 0xd8),
+    INIT_CMD(0x19, 0x18),
+    INIT_CMD(0x1b, 0xc0),
+    INIT_CMD(0x1c, 0x08),
+    INIT_CMD(0x1d, 0x02),
+    INIT_CMD(0x1e, 0x00),
+    INIT_CMD(0x1f, 0x00),
+    INIT_CMD(0x20, 0x00),
+    INIT_CMD(0x21, 0xd8),
+    INIT_CMD(0x22, 0x18),
+    INIT_CMD(0x4c, 0x80),
+    INIT_CMD(0x4d, 0x00),
+    INIT_CMD(0x4e, 0x01),
+    INIT_CMD(0x4f, 0x00),
+    INIT_CMD(0x50, 0x01),
+    INIT_CMD(0x51, 0x01),
+    INIT_CMD(0x52, 0x01),
+    INIT_CMD(0x53, 0xc6),
+    INIT_CMD(0x54, 0x00),
+    INIT_CMD(0x55, 0x03),
+    INIT_CMD(0x56, 0x28),
+    INIT_CMD(0x58, 0x28),
+    INIT_CMD(0x65, 0x80),
+    INIT_CMD(0x66, 0x05),
+    INIT_CMD(0x67, 0x10),
 
     // === MUX Sequence Control ===
-    {0xfe00, {0xf0}, 0x01},
-    {0xa300, {0x00}, 0x01},
-
-    {0xfe00, {0x70}, 0x01},
-    {0x7600, {0x00}, 0x01},
-    {0x7700, {0x00}, 0x01},
-    {0x7800, {0x05}, 0x01},
-    {0x6800, {0x08}, 0x01},
-    {0x6900, {0x08}, 0x01},
-    {0x6a00, {0x10}, 0x01},
-    {0x6b00, {0x08}, 0x01},
-    {0x6c00, {0x08}, 0x01},
-    {0x6d00, {0x08}, 0x01},
-
-    {0xfe00, {0xf0}, 0x01},
-    {0xa900, {0x18}, 0x01},
-    {0xaa00, {0x18}, 0x01},
-    {0xab00, {0x18}, 0x01},
-    {0xac00, {0x18}, 0x01},
-    {0xad00, {0x18}, 0x01},
-    {0xae00, {0x18}, 0x01},
-
-    {0xfe00, {0x70}, 0x01},
-    {0x9300, {0x00}, 0x01},
-    {0x9400, {0x00}, 0x01},
-    {0x9600, {0x05}, 0x01},
-    {0xdb00, {0x08}, 0x01},
-    {0xdc00, {0x08}, 0x01},
-    {0xdd00, {0x10}, 0x01},
-    {0xde00, {0x08}, 0x01},
-    {0xdf00, {0x08}, 0x01},
-    {0xe000, {0x08}, 0x01},
-    {0xe700, {0x18}, 0x01},
-    {0xe800, {0x18}, 0x01},
-    {0xe900, {0x18}, 0x01},
-    {0xea00, {0x18}, 0x01},
-    {0xeb00, {0x18}, 0x01},
-    {0xec00, {0x18}, 0x01},
+    INIT_CMD(0xfe, 0xf0),
+    INIT_CMD(0xa3, 0x00),
+
+    INIT_CMD(0xfe, 0x70),
+    INIT_CMD(0x76, 0x00),
+    INIT_CMD(0x77, 0x00),
+    INIT_CMD(0x78, 0x05),
+    INIT_CMD(0x68, 0x08),
+    INIT_CMD(0x69, 0x08),
+    INIT_CMD(0x6a, 0x10),
+    INIT_CMD(0x6b, 0x08),
+    INIT_CMD(0x6c, 0x08),
+    INIT_CMD(0x6d, 0x08),
+
+    INIT_CMD(0xfe, 0xf0),
+    INIT_CMD(0xa9, 0x18),
+    INIT_CMD(0xaa, 0x18),
+    INIT_CMD(0xab, 0x18),
+    INIT_CMD(0xac, 0x18),
+    INIT_CMD(0xad, 0x18),
+    INIT_CMD(0xae, 0x18),
+
+    INIT_CMD(0xfe, 0x70),
+    INIT_CMD(0x93, 0x00),
+    INIT_CMD(0x94, 0x00),
+    INIT_CMD(0x96, 0x05),
+    INIT_CMD(0xdb, 0x08),
+    INIT_CMD(0xdc, 0x08),
+    INIT_CMD(0xdd, 0x10),
+    INIT_CMD(0xde, 0x08),
+    INIT_CMD(0xdf, 0x08),
+    INIT_CMD(0xe0, 0x08),
+    INIT_CMD(0xe7, 0x18),
+    INIT_CMD(0xe8, 0x18),
+    INIT_CMD(0xe9, 0x18),
+    INIT_CMD(0xea, 0x18),
+    INIT_CMD(0xeb, 0x18),
+    INIT_CMD(0xec, 0x18),
 
     // ===  Power on/off sequence Blank period control  ===
-    {0xfe00, {0x70}, 0x01},
-    {0xd100, {0xf0}, 0x01},
-    {0xd200, {0xff}, 0x01},
-    {0xd300, {0xf0}, 0x01},
-    {0xd400, {0xff}, 0x01},
-    {0xd500, {0xa0}, 0x01},
-    {0xd600, {0xaa}, 0x01},
-    {0xd700, {0xf0}, 0x01},
-    {0xd800, {0xff}, 0x01},
+    INIT_CMD(0xfe, 0x70),
+    INIT_CMD(0xd1, 0xf0),
+    INIT_CMD(0xd2, 0xff),
+    INIT_CMD(0xd3, 0xf0),
+    INIT_CMD(0xd4, 0xff),
+    INIT_CMD(0xd5, 0xa0),
+    INIT_CMD(0xd6, 0xaa),
+    INIT_CMD(0xd7, 0xf0),
+    INIT_CMD(0xd8, 0xff),
 
     // ===  Source  ===
-    {0xfe00, {0x40}, 0x01},
-    {0x4d00, {0xaa}, 0x01},
-    {0x4e00, {0x00}, 0x01},
-    {0x4f00, {0xa0}, 0x01},
-    {0x5000, {0x00}, 0x01},
-    {0x5100, {0xf3}, 0x01},
-    {0x5200, {0x23}, 0x01},
-    {0x6b00, {0xf3}, 0x01},
-    {0x6c00, {0x13}, 0x01},
-    {0x8f00, {0xff}, 0x01},
-    {0x9000, {0xff}, 0x01},
-    {0x9100, {0x3f}, 0x01},
-    {0xa200, {0x10}, 0x01},
-    {0x0700, {0x21}, 0x01},
-    {0x3500, {0x81}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x4d, 0xaa),
+    INIT_CMD(0x4e, 0x00),
+    INIT_CMD(0x4f, 0xa0),
+    INIT_CMD(0x50, 0x00),
+    INIT_CMD(0x51, 0xf3),
+    INIT_CMD(0x52, 0x23),
+    INIT_CMD(0x6b, 0xf3),
+    INIT_CMD(0x6c, 0x13),
+    INIT_CMD(0x8f, 0xff),
+    INIT_CMD(0x90, 0xff),
+    INIT_CMD(0x91, 0x3f),
+    INIT_CMD(0xa2, 0x10),
+    INIT_CMD(0x07, 0x21),
+    INIT_CMD(0x35, 0x81),
 
     // === gamma setting  ===
-    {0xfe00, {0x40}, 0x01},
-    {0x3300, {0x10}, 0x01},
-    {0xfe00, {0x50}, 0x01},
-    {0xa900, {0x30}, 0x01},
-    {0xaa00, {0xb8}, 0x01},
-    {0xab00, {0x01}, 0x01},
-    {0xfe00, {0x60}, 0x01},
-    {0xa900, {0x30}, 0x01},
-    {0xaa00, {0x90}, 0x01},
-    {0xab00, {0x01}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x33, 0x10),
+    INIT_CMD(0xfe, 0x50),
+    INIT_CMD(0xa9, 0x30),
+    INIT_CMD(0xaa, 0xb8),
+    INIT_CMD(0xab, 0x01),
+    INIT_CMD(0xfe, 0x60),
+    INIT_CMD(0xa9, 0x30),
+    INIT_CMD(0xaa, 0x90),
+    INIT_CMD(0xab, 0x01),
 
     //=== Watchedge ===
-    {0xfe00, {0x90}, 0x01},
-    {0xa400, {0x16}, 0x01}, //{0xa400,{0x16},0x01},
-    {0xa500, {0x16}, 0x01}, //{0xa500,{0x16},0x01},
-    {0xa600, {0x00}, 0x01},
-    {0xa700, {0x16}, 0x01}, //{0xa700,{0x16},0x01},
-    {0xa900, {0x16}, 0x01}, //{0xa900,{0x16},0x01},
-    {0xaa00, {0x80}, 0x01},
-    {0xab00, {0x0f}, 0x01}, //{0xab00,{0x0f},0x01},
-    {0xac00, {0xff}, 0x01}, //{0xac00,{0xff},0x01},
-    {0xae00, {0x3f}, 0x01}, //{0xae00,{0x3f},0x01},
-
-    {0x3f00, {0x58}, 0x01},
-    {0x4000, {0xb4}, 0x01},
-    {0x4100, {0x29}, 0x01},
+    INIT_CMD(0xfe, 0x90),
+    INIT_CMD(0xa4, 0x16), //INIT_CMD(0xa4, 0x16),
+    INIT_CMD(0xa5, 0x16), //INIT_CMD(0xa5, 0x16),
+    INIT_CMD(0xa6, 0x00),
+    INIT_CMD(0xa7, 0x16), //INIT_CMD(0xa7, 0x16),
+    INIT_CMD(0xa9, 0x16), //INIT_CMD(0xa9, 0x16),
+    INIT_CMD(0xaa, 0x80),
+    INIT_CMD(0xab, 0x0f), //INIT_CMD(0xab, 0x0f),
+    INIT_CMD(0xac, 0xff), //INIT_CMD(0xac, 0xff),
+    INIT_CMD(0xae, 0x3f), //INIT_CMD(0xae, 0x3f),
+
+    INIT_CMD(0x3f, 0x58),
+    INIT_CMD(0x40, 0xb4),
+    INIT_CMD(0x41, 0x29),
 
     //=== SCC ===
-    {0xfe00, {0x90}, 0x01},
-    {0x5100, {0x00}, 0x01},
-    {0x5200, {0x08}, 0x01},
-    {0x5300, {0x00}, 0x01},
-    {0x5400, {0x18}, 0x01},
-    {0x5500, {0x00}, 0x01},
-    {0x5600, {0x00}, 0x01},
-    {0x5700, {0x00}, 0x01},
-    {0x5800, {0x00}, 0x01},
-    {0x5900, {0x08}, 0x01},
-    {0x5a00, {0x00}, 0x01},
-    {0x5b00, {0x18}, 0x01},
-    {0x5c00, {0x00}, 0x01},
-    {0x5d00, {0x00}, 0x01},
-    {0x5e00, {0x80}, 0x01},
-    {0x5f00, {0x00}, 0x01},
-    {0x6000, {0x00}, 0x01},
-    {0x6100, {0x00}, 0x01},
-    {0x6200, {0x18}, 0x01},
-    {0x6300, {0x00}, 0x01},
-    {0x6400, {0x00}, 0x01},
-    {0x6500, {0x00}, 0x01},
-    {0x6600, {0x08}, 0x01},
-    {0x6700, {0x80}, 0x01},
-    {0x6800, {0x40}, 0x01},
-    {0x6900, {0x00}, 0x01},
-    {0x6a00, {0x00}, 0x01},
-    {0x6b00, {0x00}, 0x01},
-    {0x6c00, {0x00}, 0x01},
-    {0x6d00, {0x00}, 0x01},
-    {0x6e00, {0x00}, 0x01},
-    {0x6f00, {0x18}, 0x01},
-    {0x7000, {0x80}, 0x01},
-    {0x7100, {0x00}, 0x01},
-    {0x7200, {0x00}, 0x01},
-    {0x7300, {0x00}, 0x01},
-    {0x7400, {0x00}, 0x01},
-    {0x7500, {0x00}, 0x01},
-    {0x7600, {0x18}, 0x01},
-    {0x7700, {0x00}, 0x01},
-    {0x7800, {0x08}, 0x01},
-    {0x7900, {0x00}, 0x01},
-    {0x7a00, {0x00}, 0x01},
-    {0x7b00, {0x00}, 0x01},
-    {0x7c00, {0x00}, 0x01},
-    {0x7d00, {0x18}, 0x01},
-    {0x7e00, {0x00}, 0x01},
-    {0x7f00, {0x08}, 0x01},
-    {0x8000, {0x00}, 0x01},
-    {0x8100, {0x00}, 0x01},
-    {0x8200, {0x80}, 0x01},
-    {0x8300, {0x40}, 0x01},
-    {0x8400, {0x00}, 0x01},
-    {0x8500, {0x00}, 0x01},
-    {0x8600, {0x08}, 0x01},
-    {0x8700, {0x00}, 0x01},
-    {0x8800, {0x04}, 0x01},
-    {0x8900, {0x00}, 0x01},
-    {0x8a00, {0x18}, 0x01},
-    {0x8b00, {0x40}, 0x01},
-    {0x8c00, {0x00}, 0x01},
-    {0x8d00, {0x00}, 0x01},
-    {0x8e00, {0x00}, 0x01},
-    {0x8f00, {0x04}, 0x01},
-    {0x9000, {0x00}, 0x01},
-    {0x9100, {0x18}, 0x01},
-    {0x9200, {0x00}, 0x01},
-    {0x9300, {0x04}, 0x01},
-    {0x9400, {0x40}, 0x01},
-    {0x9500, {0x00}, 0x01},
-    {0x9600, {0x00}, 0x01},
-    {0x9700, {0x00}, 0x01},
-    {0x9800, {0x18}, 0x01},
-    {0x9900, {0x00}, 0x01},
-    {0x9a00, {0x04}, 0x01},
-    {0x9b00, {0x00}, 0x01},
-    {0x9c00, {0x04}, 0x01},
-    {0x9d00, {0x80}, 0x01},
-    {0x9e00, {0x40}, 0x01},
-    {0x9f00, {0x00}, 0x01},
-    {0xa000, {0x00}, 0x01},
-    {0xa200, {0x04}, 0x01},
+    INIT_CMD(0xfe, 0x90),
+    INIT_CMD(0x51, 0x00),
+    INIT_CMD(0x52, 0x08),
+    INIT_CMD(0x53, 0x00),
+    INIT_CMD(0x54, 0x18),
+    INIT_CMD(0x55, 0x00),
+    INIT_CMD(0x56, 0x00),
+    INIT_CMD(0x57, 0x00),
+    INIT_CMD(0x58, 0x00),
+    INIT_CMD(0x59, 0x08),
+    INIT_CMD(0x5a, 0x00),
+    INIT_CMD(0x5b, 0x18),
+    INIT_CMD(0x5c, 0x00),
+    INIT_CMD(0x5d, 0x00),
+    INIT_CMD(0x5e, 0x80),
+    INIT_CMD(0x5f, 0x00),
+    INIT_CMD(0x60, 0x00),
+    INIT_CMD(0x61, 0x00),
+    INIT_CMD(0x62, 0x18),
+    INIT_CMD(0x63, 0x00),
+    INIT_CMD(0x64, 0x00),
+    INIT_CMD(0x65, 0x00),
+    INIT_CMD(0x66, 0x08),
+    INIT_CMD(0x67, 0x80),
+    INIT_CMD(0x68, 0x40),
+    INIT_CMD(0x69, 0x00),
+    INIT_CMD(0x6a, 0x00),
+    INIT_CMD(0x6b, 0x00),
+    INIT_CMD(0x6c, 0x00),
+    INIT_CMD(0x6d, 0x00),
+    INIT_CMD(0x6e, 0x00),
+    INIT_CMD(0x6f, 0x18),
+    INIT_CMD(0x70, 0x80),
+    INIT_CMD(0x71, 0x00),
+    INIT_CMD(0x72, 0x00),
+    INIT_CMD(0x73, 0x00),
+    INIT_CMD(0x74, 0x00),
+    INIT_CMD(0x75, 0x00),
+    INIT_CMD(0x76, 0x18),
+    INIT_CMD(0x77, 0x00),
+    INIT_CMD(0x78, 0x08),
+    INIT_CMD(0x79, 0x00),
+    INIT_CMD(0x7a, 0x00),
+    INIT_CMD(0x7b, 0x00),
+    INIT_CMD(0x7c, 0x00),
+    INIT_CMD(0x7d, 0x18),
+    INIT_CMD(0x7e, 0x00),
+    INIT_CMD(0x7f, 0x08),
+    INIT_CMD(0x80, 0x00),
+    INIT_CMD(0x81, 0x00),
+    INIT_CMD(0x82, 0x80),
+    INIT_CMD(0x83, 0x40),
+    INIT_CMD(0x84, 0x00),
+    INIT_CMD(0x85, 0x00),
+    INIT_CMD(0x86, 0x08),
+    INIT_CMD(0x87, 0x00),
+    INIT_CMD(0x88, 0x04),
+    INIT_CMD(0x89, 0x00),
+    INIT_CMD(0x8a, 0x18),
+    INIT_CMD(0x8b, 0x40),
+    INIT_CMD(0x8c, 0x00),
+    INIT_CMD(0x8d, 0x00),
+    INIT_CMD(0x8e, 0x00),
+    INIT_CMD(0x8f, 0x04),
+    INIT_CMD(0x90, 0x00),
+    INIT_CMD(0x91, 0x18),
+    INIT_CMD(0x92, 0x00),
+    INIT_CMD(0x93, 0x04),
+    INIT_CMD(0x94, 0x40),
+    INIT_CMD(0x95, 0x00),
+    INIT_CMD(0x96, 0x00),
+    INIT_CMD(0x97, 0x00),
+    INIT_CMD(0x98, 0x18),
+    INIT_CMD(0x99, 0x00),
+    INIT_CMD(0x9a, 0x04),
+    INIT_CMD(0x9b, 0x00),
+    INIT_CMD(0x9c, 0x04),
+    INIT_CMD(0x9d, 0x80),
+    INIT_CMD(0x9e, 0x40),
+    INIT_CMD(0x9f, 0x00),
+    INIT_CMD(0xa0, 0x00),
+    INIT_CMD(0xa2, 0x04),
 
     // === Power saving ===
-    {0xfe00, {0x70}, 0x01},
-    {0x9800, {0x74}, 0x01},
-    {0xc900, {0x05}, 0x01},
-    {0xca00, {0x05}, 0x01},
-    {0xcb00, {0x05}, 0x01},
-    {0xcc00, {0x05}, 0x01},
-    {0xcd00, {0x05}, 0x01},
-    {0xce00, {0x85}, 0x01},
-    {0xcf00, {0x05}, 0x01},
-    {0xd000, {0x45}, 0x01},
-
-    {0xfe00, {0xe0}, 0x01},
-    {0x1900, {0x42}, 0x01},
-    {0x1e00, {0x42}, 0x01},
-    {0x1c00, {0x41}, 0x01},
-    {0x1800, {0x00}, 0x01},
-    {0x1b00, {0x0c}, 0x01},
-    {0x1a00, {0x9a}, 0x01},
-    {0x1d00, {0xda}, 0x01},
-    {0x2800, {0x5f}, 0x01},
-
-    {0xfe00, {0x40}, 0x01},
-    {0x5400, {0xac}, 0x01},
-    {0x5500, {0xa0}, 0x01},
-    {0x4800, {0xaa}, 0x01},
+    INIT_CMD(0xfe, 0x70),
+    INIT_CMD(0x98, 0x74),
+    INIT_CMD(0xc9, 0x05),
+    INIT_CMD(0xca, 0x05),
+    INIT_CMD(0xcb, 0x05),
+    INIT_CMD(0xcc, 0x05),
+    INIT_CMD(0xcd, 0x05),
+    INIT_CMD(0xce, 0x85),
+    INIT_CMD(0xcf, 0x05),
+    INIT_CMD(0xd0, 0x45),
+
+    INIT_CMD(0xfe, 0xe0),
+    INIT_CMD(0x19, 0x42),
+    INIT_CMD(0x1e, 0x42),
+    INIT_CMD(0x1c, 0x41),
+    INIT_CMD(0x18, 0x00),
+    INIT_CMD(0x1b, 0x0c),
+    INIT_CMD(0x1a, 0x9a),
+    INIT_CMD(0x1d, 0xda),
+    INIT_CMD(0x28, 0x5f),
+
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x54, 0xac),
+    INIT_CMD(0x55, 0xa0),
+    INIT_CMD(0x48, 0xaa),
 
     //======================== 194*368 setting ===========================
-    {0xfe00, {0x40}, 0x01},
-    {0x7600, {0x96}, 0x01},
-    {0x7700, {0xc2}, 0x01},
-    {0x7800, {0x8e}, 0x01},
-    {0x7900, {0xb3}, 0x01},
-    {0x7a00, {0x8d}, 0x01},
-    {0x7b00, {0x11}, 0x01},
+    INIT_CMD(0xfe, 0x40),
+    INIT_CMD(0x76, 0x96),
+    INIT_CMD(0x77, 0xc2),
+    INIT_CMD(0x78, 0x8e),
+    INIT_CMD(0x79, 0xb3),
+    INIT_CMD(0x7a, 0x8d),
+    INIT_CMD(0x7b, 0x11),
 
     //======================== EDGE SETTING ===========================
-    {0xfe00, {0x20}, 0x01},
-    {0x2700, {0xC2}, 0x01},
-    // {0xfe00,{0x40},0x01},//{0xfe00,{0x40},0x01},
-    // {0x7600,{0x01},0x01},
+    INIT_CMD(0xfe, 0x20),
+    INIT_CMD(0x27, 0xc2),
+    // INIT_CMD(0xfe, 0x40),//INIT_CMD(0xfe, 0x40),
+    // INIT_CMD(0x76, 0x01),
 
     /*******BIST Star**********///
     // CS0=0;SPI_WriteComm(0xFE);SPI_WriteData(0x90);CS0=1;Delay(10);
@@ -478,243 +478,248 @@ const lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGHT] = {
     // CS0=0;SPI_WriteComm(0x4D);SPI_WriteData(0x1F);CS0=1;Delay(10);// 02:Write 04:Red 08:Green 10:Blue
     // CS0=0;SPI_WriteComm(0xFE);SPI_WriteData(0x40);CS0=1;Delay(10);
     // CS0=0;SPI_WriteComm(0x54);SPI_WriteData(0xAF);CS0=1;Delay(10);
-    // {0xFE00,{0x90},0x01},
-    // {0xAA00,{0x00},0x01},
-    // {0xFE00,{0xD0},0x01},
-    // {0x4E00,{0x80},0x01},
-    // {0x4D00,{0x1F},0x01},
-    // {0xFE00,{0x40},0x01},
-    // {0x5400,{0xAF},0x01},
+    // INIT_CMD(0xfe, 0x90),
+    // INIT_CMD(0xaa, 0x00),
+    // INIT_CMD(0xfe, 0xd0),
+    // INIT_CMD(0x4e, 0x80),
+    // INIT_CMD(0x4d, 0x1f),
+    // INIT_CMD(0xfe, 0x40),
+    // INIT_CMD(0x54, 0xaf),
 
     /************BIST end***********///
     //=== CMD1 setting ===
-    {0xfe00, {0x00}, 0x01},
-    {0xc400, {0x80}, 0x01},
-    {0x3a00, {0x55}, 0x01},
-    {0x3500, {0x00}, 0x01},
-    {0x5300, {0x20}, 0x01},
-    {0x5100, {AMOLED_DEFAULT_BRIGHTNESS}, 0x01},
-    {0x6300, {0xff}, 0x01},
-    {0x2a00, {0x00, 0x00, 0x00, 0xc1}, 0x04},
-    {0x2b00, {0x00, 0x00, 0x01, 0x6f}, 0x04},
-    {0x1100, {}, 0x80},
-    {0x2900, {}, 0x80},
+    INIT_CMD(0xfe, 0x00),
+    INIT_CMD(0xc4, 0x80),
+    INIT_CMD(0x3a, 0x55),
+    INIT_CMD(0x35, 0x00),
+    INIT_CMD(0x53, 0x20),
+    INIT_CMD(0x51, AMOLED_DEFAULT_BRIGHTNESS),
+    INIT_CMD(0x63, 0xff),
+    INIT_CMD(0x2a, 0x00, 0x00, 0x00, 0xc1),
+    INIT_CMD(0x2b, 0x00, 0x00, 0x01, 0x6f),
+    INIT_CMD0_DELAY(0x11, 120),
+    INIT_CMD0_DELAY(0x29, 120),
+    INIT_SEQ_END
 };
 
-const lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGHT] = {
-    {0x1100, {0x00}, 0x80}, // Sleep Out
-    // {0x44, {0x01, 0x66},        0x02}, //Set_Tear_Scanline
-    // {0x35, {0x00},        0x00}, //TE ON
-    // {0x34, {0x00},        0x00}, //TE OFF
-    // {0x36, {0x00},        0x01}, //Scan Direction Control
-    {0x3A00, {0x55}, 0x01}, // Interface Pixel Format 16bit/pixel
-    // {0x3A, {0x66},        0x01}, //Interface Pixel Format    18bit/pixel
-    // {0x3A, {0x77},        0x01}, //Interface Pixel Format    24bit/pixel
-    {0x5100, {0x00}, 0x01}, // Write Display Brightness MAX_VAL=0XFF
-    {0x2900, {0x00}, 0x80}, // Display on
-    {0x5100, {AMOLED_DEFAULT_BRIGHTNESS}, 0x01}, // Write Display Brightness   MAX_VAL=0XFF
-    {0x3600, {0x60}, 0x01}, //
+const uint8_t rm67162_cmd[] = {
+    INIT_CMD0_DELAY(0x11, 120), // Sleep Out
+    // INIT_CMD(0x44, 0x01, 0x66), //Set_Tear_Scanline
+    // INIT_CMD0(0x35), //TE ON
+    // INIT_CMD0(0x34), //TE OFF
+    // INIT_CMD(0x36, 0x00), //Scan Direction Control
+    INIT_CMD(0x3a, 0x55), // Interface Pixel Format 16bit/pixel
+    // INIT_CMD(0x3a, 0x66), //Interface Pixel Format    18bit/pixel
+    // INIT_CMD(0x3a, 0x77), //Interface Pixel Format    24bit/pixel
+    INIT_CMD(0x51, 0x00), // Write Display Brightness MAX_VAL=0XFF
+    INIT_CMD0_DELAY(0x29, 120), // Display on
+    INIT_CMD(0x51, AMOLED_DEFAULT_BRIGHTNESS), // Write Display Brightness   MAX_VAL=0XFF
+    INIT_CMD(0x36, 0x60), //
+    INIT_SEQ_END
 };
 
-const lcd_cmd_t rm690b0_cmd[RM690B0_INIT_SEQUENCE_LENGHT] = {
-    {0xFE00, {0x20}, 0x01},           //SET PAGE
-    {0x2600, {0x0A}, 0x01},           //MIPI OFF
-    {0x2400, {0x80}, 0x01},           //SPI write RAM
-    {0x5A00, {0x51}, 0x01},           //! 230918:SWIRE FOR BV6804
-    {0x5B00, {0x2E}, 0x01},           //! 230918:SWIRE FOR BV6804
-    {0xFE00, {0x00}, 0x01},           //SET PAGE
-    {0x3A00, {0x55}, 0x01},           //Interface Pixel Format    16bit/pixel
-    {0xC200, {0x00}, 0x21},           //delay_ms(10);
-    {0x3500, {0x00}, 0x01},           //TE ON
-    {0x5100, {0x00}, 0x01},           //Write Display Brightness  MAX_VAL=0XFF
-    {0x1100, {0x00}, 0x80},           //Sleep Out delay_ms(120);
-    {0x2900, {0x00}, 0x20},           //Display on delay_ms(10);
-    {0x5100, {0xFF}, 0x01},           //Write Display Brightness  MAX_VAL=0XFF
+const uint8_t rm690b0_cmd[] = {
+    INIT_CMD(0xfe, 0x20),           //SET PAGE
+    INIT_CMD(0x26, 0x0a),           //MIPI OFF
+    INIT_CMD(0x24, 0x80),           //SPI write RAM
+    INIT_CMD(0x5a, 0x51),           //! 230918:SWIRE FOR BV6804
+    INIT_CMD(0x5b, 0x2e),           //! 230918:SWIRE FOR BV6804
+    INIT_CMD(0xfe, 0x00),           //SET PAGE
+    INIT_CMD(0x3a, 0x55),           //Interface Pixel Format    16bit/pixel
+    INIT_CMD_DELAY(0xc2, 10, 0x00),           //delay_ms(10);
+    INIT_CMD(0x35, 0x00),           //TE ON
+    INIT_CMD(0x51, 0x00),           //Write Display Brightness  MAX_VAL=0XFF
+    INIT_CMD0_DELAY(0x11, 120),           //Sleep Out delay_ms(120);
+    INIT_CMD0_DELAY(0x29, 10),           //Display on delay_ms(10);
+    INIT_CMD(0x51, 0xff),           //Write Display Brightness  MAX_VAL=0XFF
+    INIT_SEQ_END
 };
 
-const lcd_cmd_t jd9613_cmd[JD9613_INIT_SEQUENCE_LENGHT] = {
-    {0xfe, {0x01}, 0x02},
-    {0xf7, {0x96, 0x13, 0xa9}, 0x04},
-    {0x90, {0x01}, 0x02},
-    {0x2c, {0x19, 0x0b, 0x24, 0x1b, 0x1b, 0x1b, 0xaa, 0x50, 0x01, 0x16, 0x04, 0x04, 0x04, 0xd7}, 0x0f},
-    {0x2d, {0x66, 0x56, 0x55}, 0x04},
-    {0x2e, {0x24, 0x04, 0x3f, 0x30, 0x30, 0xa8, 0xb8, 0xb8, 0x07}, 0x0a},
-    {0x33, {0x03, 0x03, 0x03, 0x19, 0x19, 0x19, 0x13, 0x13, 0x13, 0x1a, 0x1a, 0x1a}, 0x0d},
-    {0x10, {0x0b, 0x08, 0x64, 0xae, 0x0b, 0x08, 0x64, 0xae, 0x00, 0x80, 0x00, 0x00, 0x01}, 0x0e},
-    {0x11, {0x01, 0x1e, 0x01, 0x1e, 0x00}, 0x06},
-    {0x03, {0x93, 0x1c, 0x00, 0x01, 0x7e}, 0x06},
-    {0x19, {0x00}, 0x02},
-    {0x31, {0x1b, 0x00, 0x06, 0x05, 0x05, 0x05}, 0x07},
-    {0x35, {0x00, 0x80, 0x80, 0x00}, 0x05},
-    {0x12, {0x1b}, 0x02},
-    {0x1a, {0x01, 0x20, 0x00, 0x08, 0x01, 0x06, 0x06, 0x06}, 0x09},
-    {0x74, {0xbd, 0x00, 0x01, 0x08, 0x01, 0xbb, 0x98}, 0x08},
-    {0x6c, {0xdc, 0x08, 0x02, 0x01, 0x08, 0x01, 0x30, 0x08, 0x00}, 0x0a},
-    {0x6d, {0xdc, 0x08, 0x02, 0x01, 0x08, 0x02, 0x30, 0x08, 0x00}, 0x0a},
-    {0x76, {0xda, 0x00, 0x02, 0x20, 0x39, 0x80, 0x80, 0x50, 0x05}, 0x0a},
-    {0x6e, {0xdc, 0x00, 0x02, 0x01, 0x00, 0x02, 0x4f, 0x02, 0x00}, 0x0a},
-    {0x6f, {0xdc, 0x00, 0x02, 0x01, 0x00, 0x01, 0x4f, 0x02, 0x00}, 0x0a},
-    {0x80, {0xbd, 0x00, 0x01, 0x08, 0x01, 0xbb, 0x98}, 0x08},
-    {0x78, {0xdc, 0x08, 0x02, 0x01, 0x08, 0x01, 0x30, 0x08, 0x00}, 0x0a},
-    {0x79, {0xdc, 0x08, 0x02, 0x01, 0x08, 0x02, 0x30, 0x08, 0x00}, 0x0a},
-    {0x82, {0xda, 0x40, 0x02, 0x20, 0x39, 0x00, 0x80, 0x50, 0x05}, 0x0a},
-    {0x7a, {0xdc, 0x00, 0x02, 0x01, 0x00, 0x02, 0x4f, 0x02, 0x00}, 0x0a},
-    {0x7b, {0xdc, 0x00, 0x02, 0x01, 0x00, 0x01, 0x4f, 0x02, 0x00}, 0x0a},
-    {0x84, {0x01, 0x00, 0x09, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19}, 0x0b},
-    {0x85, {0x19, 0x19, 0x19, 0x03, 0x02, 0x08, 0x19, 0x19, 0x19, 0x19}, 0x0b},
-    {0x20, {0x20, 0x00, 0x08, 0x00, 0x02, 0x00, 0x40, 0x00, 0x10, 0x00, 0x04, 0x00}, 0x0d},
-    {0x1e, {0x40, 0x00, 0x10, 0x00, 0x04, 0x00, 0x20, 0x00, 0x08, 0x00, 0x02, 0x00}, 0x0d},
-    {0x24, {0x20, 0x00, 0x08, 0x00, 0x02, 0x00, 0x40, 0x00, 0x10, 0x00, 0x04, 0x00}, 0x0d},
-    {0x22, {0x40, 0x00, 0x10, 0x00, 0x04, 0x00, 0x20, 0x00, 0x08, 0x00, 0x02, 0x00}, 0x0d},
-    {0x13, {0x63, 0x52, 0x41}, 0x04},
-    {0x14, {0x36, 0x25, 0x14}, 0x04},
-    {0x15, {0x63, 0x52, 0x41}, 0x04},
-    {0x16, {0x36, 0x25, 0x14}, 0x04},
-    {0x1d, {0x10, 0x00, 0x00}, 0x04},
-    {0x2a, {0x0d, 0x07}, 0x03},
-    {0x27, {0x00, 0x01, 0x02, 0x03, 0x04, 0x05}, 0x07},
-    {0x28, {0x00, 0x01, 0x02, 0x03, 0x04, 0x05}, 0x07},
-    {0x26, {0x01, 0x01}, 0x03},
-    {0x86, {0x01, 0x01}, 0x03},
-    {0xfe, {0x02}, 0x02},
-    {0x16, {0x81, 0x43, 0x23, 0x1e, 0x03}, 0x06},
-    {0xfe, {0x03}, 0x02},
-    {0x60, {0x01}, 0x02},
-    {0x61, {0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x0d, 0x26, 0x5a, 0x80, 0x80, 0x95, 0xf8, 0x3b, 0x75}, 0x10},
-    {0x62, {0x21, 0x22, 0x32, 0x43, 0x44, 0xd7, 0x0a, 0x59, 0xa1, 0xe1, 0x52, 0xb7, 0x11, 0x64, 0xb1}, 0x10},
-    {0x63, {0x54, 0x55, 0x66, 0x06, 0xfb, 0x3f, 0x81, 0xc6, 0x06, 0x45, 0x83}, 0x0c},
-    {0x64, {0x00, 0x00, 0x11, 0x11, 0x21, 0x00, 0x23, 0x6a, 0xf8, 0x63, 0x67, 0x70, 0xa5, 0xdc, 0x02}, 0x10},
-    {0x65, {0x22, 0x22, 0x32, 0x43, 0x44, 0x24, 0x44, 0x82, 0xc1, 0xf8, 0x61, 0xbf, 0x13, 0x62, 0xad}, 0x10},
-    {0x66, {0x54, 0x55, 0x65, 0x06, 0xf5, 0x37, 0x76, 0xb8, 0xf5, 0x31, 0x6c}, 0x0c},
-    {0x67, {0x00, 0x10, 0x22, 0x22, 0x22, 0x00, 0x37, 0xa4, 0x7e, 0x22, 0x25, 0x2c, 0x4c, 0x72, 0x9a}, 0x10},
-    {0x68, {0x22, 0x33, 0x43, 0x44, 0x55, 0xc1, 0xe5, 0x2d, 0x6f, 0xaf, 0x23, 0x8f, 0xf3, 0x50, 0xa6}, 0x10},
-    {0x69, {0x65, 0x66, 0x77, 0x07, 0xfd, 0x4e, 0x9c, 0xed, 0x39, 0x86, 0xd3}, 0x0c},
-    {0xfe, {0x05}, 0x02},
-    {0x61, {0x00, 0x31, 0x44, 0x54, 0x55, 0x00, 0x92, 0xb5, 0x88, 0x19, 0x90, 0xe8, 0x3e, 0x71, 0xa5}, 0x10},
-    {0x62, {0x55, 0x66, 0x76, 0x77, 0x88, 0xce, 0xf2, 0x32, 0x6e, 0xc4, 0x34, 0x8b, 0xd9, 0x2a, 0x7d}, 0x10},
-    {0x63, {0x98, 0x99, 0xaa, 0x0a, 0xdc, 0x2e, 0x7d, 0xc3, 0x0d, 0x5b, 0x9e}, 0x0c},
-    {0x64, {0x00, 0x31, 0x44, 0x54, 0x55, 0x00, 0xa2, 0xe5, 0xcd, 0x5c, 0x94, 0xcf, 0x09, 0x4a, 0x72}, 0x10},
-    {0x65, {0x55, 0x65, 0x66, 0x77, 0x87, 0x9c, 0xc2, 0xff, 0x36, 0x6a, 0xec, 0x45, 0x91, 0xd8, 0x20}, 0x10},
-    {0x66, {0x88, 0x98, 0x99, 0x0a, 0x68, 0xb0, 0xfb, 0x43, 0x8c, 0xd5, 0x0e}, 0x0c},
-    {0x67, {0x00, 0x42, 0x55, 0x55, 0x55, 0x00, 0xcb, 0x62, 0xc5, 0x09, 0x44, 0x72, 0xa9, 0xd6, 0xfd}, 0x10},
-    {0x68, {0x66, 0x66, 0x77, 0x87, 0x98, 0x21, 0x45, 0x96, 0xed, 0x29, 0x90, 0xee, 0x4b, 0xb1, 0x13}, 0x10},
-    {0x69, {0x99, 0xaa, 0xba, 0x0b, 0x6a, 0xb8, 0x0d, 0x62, 0xb8, 0x0e, 0x54}, 0x0c},
-    {0xfe, {0x07}, 0x02},
-    {0x3e, {0x00}, 0x02},
-    {0x42, {0x03, 0x10}, 0x03},
-    {0x4a, {0x31}, 0x02},
-    {0x5c, {0x01}, 0x02},
-    {0x3c, {0x07, 0x00, 0x24, 0x04, 0x3f, 0xe2}, 0x07},
-    {0x44, {0x03, 0x40, 0x3f, 0x02}, 0x05},
-    {0x12, {0xaa, 0xaa, 0xc0, 0xc8, 0xd0, 0xd8, 0xe0, 0xe8, 0xf0, 0xf8}, 0x0b},
-    {0x11, {0xaa, 0xaa, 0xaa, 0x60, 0x68, 0x70, 0x78, 0x80, 0x88, 0x90, 0x98, 0xa0, 0xa8, 0xb0, 0xb8}, 0x10},
-    {0x10, {0xaa, 0xaa, 0xaa, 0x00, 0x08, 0x10, 0x18, 0x20, 0x28, 0x30, 0x38, 0x40, 0x48, 0x50, 0x58}, 0x10},
-    {0x14, {0x03, 0x1f, 0x3f, 0x5f, 0x7f, 0x9f, 0xbf, 0xdf, 0x03, 0x1f, 0x3f, 0x5f, 0x7f, 0x9f, 0xbf, 0xdf}, 0x11},
-    {0x18, {0x70, 0x1a, 0x22, 0xbb, 0xaa, 0xff, 0x24, 0x71, 0x0f, 0x01, 0x00, 0x03}, 0x0d},
-    {0xfe, {0x00}, 0x02},
-    {0x3a, {0x55}, 0x02},
-    {0xc4, {0x80}, 0x02},
-    {0x2a, {0x00, 0x00, 0x00, 0x7d}, 0x05},
-    {0x2b, {0x00, 0x00, 0x01, 0x25}, 0x05},
-    {0x35, {0x00}, 0x02},
-    {0x53, {0x28}, 0x02},
-    {0x51, {0xff}, 0x02},
-    {0, {0}, 0xff},
+const uint8_t jd9613_cmd[] = {
+    INIT_CMD(0xfe, 0x01),
+    INIT_CMD(0xf7, 0x96, 0x13, 0xa9),
+    INIT_CMD(0x90, 0x01),
+    INIT_CMD(0x2c, 0x19, 0x0b, 0x24, 0x1b, 0x1b, 0x1b, 0xaa, 0x50, 0x01, 0x16, 0x04, 0x04, 0x04, 0xd7),
+    INIT_CMD(0x2d, 0x66, 0x56, 0x55),
+    INIT_CMD(0x2e, 0x24, 0x04, 0x3f, 0x30, 0x30, 0xa8, 0xb8, 0xb8, 0x07),
+    INIT_CMD(0x33, 0x03, 0x03, 0x03, 0x19, 0x19, 0x19, 0x13, 0x13, 0x13, 0x1a, 0x1a, 0x1a),
+    INIT_CMD(0x10, 0x0b, 0x08, 0x64, 0xae, 0x0b, 0x08, 0x64, 0xae, 0x00, 0x80, 0x00, 0x00, 0x01),
+    INIT_CMD(0x11, 0x01, 0x1e, 0x01, 0x1e, 0x00),
+    INIT_CMD(0x03, 0x93, 0x1c, 0x00, 0x01, 0x7e),
+    INIT_CMD(0x19, 0x00),
+    INIT_CMD(0x31, 0x1b, 0x00, 0x06, 0x05, 0x05, 0x05),
+    INIT_CMD(0x35, 0x00, 0x80, 0x80, 0x00),
+    INIT_CMD(0x12, 0x1b),
+    INIT_CMD(0x1a, 0x01, 0x20, 0x00, 0x08, 0x01, 0x06, 0x06, 0x06),
+    INIT_CMD(0x74, 0xbd, 0x00, 0x01, 0x08, 0x01, 0xbb, 0x98),
+    INIT_CMD(0x6c, 0xdc, 0x08, 0x02, 0x01, 0x08, 0x01, 0x30, 0x08, 0x00),
+    INIT_CMD(0x6d, 0xdc, 0x08, 0x02, 0x01, 0x08, 0x02, 0x30, 0x08, 0x00),
+    INIT_CMD(0x76, 0xda, 0x00, 0x02, 0x20, 0x39, 0x80, 0x80, 0x50, 0x05),
+    INIT_CMD(0x6e, 0xdc, 0x00, 0x02, 0x01, 0x00, 0x02, 0x4f, 0x02, 0x00),
+    INIT_CMD(0x6f, 0xdc, 0x00, 0x02, 0x01, 0x00, 0x01, 0x4f, 0x02, 0x00),
+    INIT_CMD(0x80, 0xbd, 0x00, 0x01, 0x08, 0x01, 0xbb, 0x98),
+    INIT_CMD(0x78, 0xdc, 0x08, 0x02, 0x01, 0x08, 0x01, 0x30, 0x08, 0x00),
+    INIT_CMD(0x79, 0xdc, 0x08, 0x02, 0x01, 0x08, 0x02, 0x30, 0x08, 0x00),
+    INIT_CMD(0x82, 0xda, 0x40, 0x02, 0x20, 0x39, 0x00, 0x80, 0x50, 0x05),
+    INIT_CMD(0x7a, 0xdc, 0x00, 0x02, 0x01, 0x00, 0x02, 0x4f, 0x02, 0x00),
+    INIT_CMD(0x7b, 0xdc, 0x00, 0x02, 0x01, 0x00, 0x01, 0x4f, 0x02, 0x00),
+    INIT_CMD(0x84, 0x01, 0x00, 0x09, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19),
+    INIT_CMD(0x85, 0x19, 0x19, 0x19, 0x03, 0x02, 0x08, 0x19, 0x19, 0x19, 0x19),
+    INIT_CMD(0x20, 0x20, 0x00, 0x08, 0x00, 0x02, 0x00, 0x40, 0x00, 0x10, 0x00, 0x04, 0x00),
+    INIT_CMD(0x1e, 0x40, 0x00, 0x10, 0x00, 0x04, 0x00, 0x20, 0x00, 0x08, 0x00, 0x02, 0x00),
+    INIT_CMD(0x24, 0x20, 0x00, 0x08, 0x00, 0x02, 0x00, 0x40, 0x00, 0x10, 0x00, 0x04, 0x00),
+    INIT_CMD(0x22, 0x40, 0x00, 0x10, 0x00, 0x04, 0x00, 0x20, 0x00, 0x08, 0x00, 0x02, 0x00),
+    INIT_CMD(0x13, 0x63, 0x52, 0x41),
+    INIT_CMD(0x14, 0x36, 0x25, 0x14),
+    INIT_CMD(0x15, 0x63, 0x52, 0x41),
+    INIT_CMD(0x16, 0x36, 0x25, 0x14),
+    INIT_CMD(0x1d, 0x10, 0x00, 0x00),
+    INIT_CMD(0x2a, 0x0d, 0x07),
+    INIT_CMD(0x27, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05),
+    INIT_CMD(0x28, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05),
+    INIT_CMD(0x26, 0x01, 0x01),
+    INIT_CMD(0x86, 0x01, 0x01),
+    INIT_CMD(0xfe, 0x02),
+    INIT_CMD(0x16, 0x81, 0x43, 0x23, 0x1e, 0x03),
+    INIT_CMD(0xfe, 0x03),
+    INIT_CMD(0x60, 0x01),
+    INIT_CMD(0x61, 0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x0d, 0x26, 0x5a, 0x80, 0x80, 0x95, 0xf8, 0x3b, 0x75),
+    INIT_CMD(0x62, 0x21, 0x22, 0x32, 0x43, 0x44, 0xd7, 0x0a, 0x59, 0xa1, 0xe1, 0x52, 0xb7, 0x11, 0x64, 0xb1),
+    INIT_CMD(0x63, 0x54, 0x55, 0x66, 0x06, 0xfb, 0x3f, 0x81, 0xc6, 0x06, 0x45, 0x83),
+    INIT_CMD(0x64, 0x00, 0x00, 0x11, 0x11, 0x21, 0x00, 0x23, 0x6a, 0xf8, 0x63, 0x67, 0x70, 0xa5, 0xdc, 0x02),
+    INIT_CMD(0x65, 0x22, 0x22, 0x32, 0x43, 0x44, 0x24, 0x44, 0x82, 0xc1, 0xf8, 0x61, 0xbf, 0x13, 0x62, 0xad),
+    INIT_CMD(0x66, 0x54, 0x55, 0x65, 0x06, 0xf5, 0x37, 0x76, 0xb8, 0xf5, 0x31, 0x6c),
+    INIT_CMD(0x67, 0x00, 0x10, 0x22, 0x22, 0x22, 0x00, 0x37, 0xa4, 0x7e, 0x22, 0x25, 0x2c, 0x4c, 0x72, 0x9a),
+    INIT_CMD(0x68, 0x22, 0x33, 0x43, 0x44, 0x55, 0xc1, 0xe5, 0x2d, 0x6f, 0xaf, 0x23, 0x8f, 0xf3, 0x50, 0xa6),
+    INIT_CMD(0x69, 0x65, 0x66, 0x77, 0x07, 0xfd, 0x4e, 0x9c, 0xed, 0x39, 0x86, 0xd3),
+    INIT_CMD(0xfe, 0x05),
+    INIT_CMD(0x61, 0x00, 0x31, 0x44, 0x54, 0x55, 0x00, 0x92, 0xb5, 0x88, 0x19, 0x90, 0xe8, 0x3e, 0x71, 0xa5),
+    INIT_CMD(0x62, 0x55, 0x66, 0x76, 0x77, 0x88, 0xce, 0xf2, 0x32, 0x6e, 0xc4, 0x34, 0x8b, 0xd9, 0x2a, 0x7d),
+    INIT_CMD(0x63, 0x98, 0x99, 0xaa, 0x0a, 0xdc, 0x2e, 0x7d, 0xc3, 0x0d, 0x5b, 0x9e),
+    INIT_CMD(0x64, 0x00, 0x31, 0x44, 0x54, 0x55, 0x00, 0xa2, 0xe5, 0xcd, 0x5c, 0x94, 0xcf, 0x09, 0x4a, 0x72),
+    INIT_CMD(0x65, 0x55, 0x65, 0x66, 0x77, 0x87, 0x9c, 0xc2, 0xff, 0x36, 0x6a, 0xec, 0x45, 0x91, 0xd8, 0x20),
+    INIT_CMD(0x66, 0x88, 0x98, 0x99, 0x0a, 0x68, 0xb0, 0xfb, 0x43, 0x8c, 0xd5, 0x0e),
+    INIT_CMD(0x67, 0x00, 0x42, 0x55, 0x55, 0x55, 0x00, 0xcb, 0x62, 0xc5, 0x09, 0x44, 0x72, 0xa9, 0xd6, 0xfd),
+    INIT_CMD(0x68, 0x66, 0x66, 0x77, 0x87, 0x98, 0x21, 0x45, 0x96, 0xed, 0x29, 0x90, 0xee, 0x4b, 0xb1, 0x13),
+    INIT_CMD(0x69, 0x99, 0xaa, 0xba, 0x0b, 0x6a, 0xb8, 0x0d, 0x62, 0xb8, 0x0e, 0x54),
+    INIT_CMD(0xfe, 0x07),
+    INIT_CMD(0x3e, 0x00),
+    INIT_CMD(0x42, 0x03, 0x10),
+    INIT_CMD(0x4a, 0x31),
+    INIT_CMD(0x5c, 0x01),
+    INIT_CMD(0x3c, 0x07, 0x00, 0x24, 0x04, 0x3f, 0xe2),
+    INIT_CMD(0x44, 0x03, 0x40, 0x3f, 0x02),
+    INIT_CMD(0x12, 0xaa, 0xaa, 0xc0, 0xc8, 0xd0, 0xd8, 0xe0, 0xe8, 0xf0, 0xf8),
+    INIT_CMD(0x11, 0xaa, 0xaa, 0xaa, 0x60, 0x68, 0x70, 0x78, 0x80, 0x88, 0x90, 0x98, 0xa0, 0xa8, 0xb0, 0xb8),
+    INIT_CMD(0x10, 0xaa, 0xaa, 0xaa, 0x00, 0x08, 0x10, 0x18, 0x20, 0x28, 0x30, 0x38, 0x40, 0x48, 0x50, 0x58),
+    INIT_CMD(0x14, 0x03, 0x1f, 0x3f, 0x5f, 0x7f, 0x9f, 0xbf, 0xdf, 0x03, 0x1f, 0x3f, 0x5f, 0x7f, 0x9f, 0xbf, 0xdf),
+    INIT_CMD(0x18, 0x70, 0x1a, 0x22, 0xbb, 0xaa, 0xff, 0x24, 0x71, 0x0f, 0x01, 0x00, 0x03),
+    INIT_CMD(0xfe, 0x00),
+    INIT_CMD(0x3a, 0x55),
+    INIT_CMD(0xc4, 0x80),
+    INIT_CMD(0x2a, 0x00, 0x00, 0x00, 0x7d),
+    INIT_CMD(0x2b, 0x00, 0x00, 0x01, 0x25),
+    INIT_CMD(0x35, 0x00),
+    INIT_CMD(0x53, 0x28),
+    INIT_CMD(0x51, 0xff),
+    INIT_CMD0_DELAY(0x11, 120), // Sleep Out
+    INIT_CMD0_DELAY(0x29, 10),  // Display on
+    INIT_SEQ_END,
 };
 
 
 
-  const lcd_cmd_t st7701_2_1_inches[ST7701_2_1_INIT_SEQUENCE_LENGHT] = {
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x10}, 0x05},
-    {0xC0, {0x3b, 0x00}, 0x02},
-    {0xC1, {0x0b, 0x02}, 0x02},
-    {0xC2, {0x07, 0x02}, 0x02},
-    {0xCC, {0x10}, 0x01},
-    {0xCD, {0x08}, 0x01}, // 用565时屏蔽    666打开
-    {0xb0, {0x00, 0x11, 0x16, 0x0e, 0x11, 0x06, 0x05, 0x09, 0x08, 0x21, 0x06, 0x13, 0x10, 0x29, 0x31, 0x18}, 0x10},
-    {0xb1, {0x00, 0x11, 0x16, 0x0e, 0x11, 0x07, 0x05, 0x09, 0x09, 0x21, 0x05, 0x13, 0x11, 0x2a, 0x31, 0x18}, 0x10},
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x11}, 0x05},
-    {0xb0, {0x6d}, 0x01},
-    {0xb1, {0x37}, 0x01},
-    {0xb2, {0x81}, 0x01},
-    {0xb3, {0x80}, 0x01},
-    {0xb5, {0x43}, 0x01},
-    {0xb7, {0x85}, 0x01},
-    {0xb8, {0x20}, 0x01},
-    {0xc1, {0x78}, 0x01},
-    {0xc2, {0x78}, 0x01},
-    {0xc3, {0x8c}, 0x01},
-    {0xd0, {0x88}, 0x01},
-    {0xe0, {0x00, 0x00, 0x02}, 0x03},
-    {0xe1, {0x03, 0xa0, 0x00, 0x00, 0x04, 0xa0, 0x00, 0x00, 0x00, 0x20, 0x20}, 0x0b},
-    {0xe2, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 0x0d},
-    {0xe3, {0x00, 0x00, 0x11, 0x00}, 0x04},
-    {0xe4, {0x22, 0x00}, 0x02},
-    {0xe5, {0x05, 0xec, 0xa0, 0xa0, 0x07, 0xee, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 0x10},
-    {0xe6, {0x00, 0x00, 0x11, 0x00}, 0x04},
-    {0xe7, {0x22, 0x00}, 0x02},
-    {0xe8, {0x06, 0xed, 0xa0, 0xa0, 0x08, 0xef, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 0x10},
-    {0xeb, {0x00, 0x00, 0x40, 0x40, 0x00, 0x00, 0x00}, 0x07},
-    {0xed, {0xff, 0xff, 0xff, 0xba, 0x0a, 0xbf, 0x45, 0xff, 0xff, 0x54, 0xfb, 0xa0, 0xab, 0xff, 0xff, 0xff}, 0x10},
-    {0xef, {0x10, 0x0d, 0x04, 0x08, 0x3f, 0x1f}, 0x06},
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x13}, 0x05},
-    {0xef, {0x08}, 0x01},
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x00}, 0x05},
-    {0x36, {0x08}, 0x01},
-    {0x3a, {0x66}, 0x01},
-    {0x11, {0x00}, 0x80},
-    // {0xFF, {0x77, 0x01, 0x00, 0x00, 0x12}, 0x05},
-    // {0xd1, {0x81}, 0x01},
-    // {0xd2, {0x06}, 0x01},
-    {0x29, {0x00}, 0x80},
-    {0, {0}, 0xff}
+const uint8_t st7701_2_1_inches[] = {
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x10),
+    INIT_CMD(0xc0, 0x3b, 0x00),
+    INIT_CMD(0xc1, 0x0b, 0x02),
+    INIT_CMD(0xc2, 0x07, 0x02),
+    INIT_CMD(0xcc, 0x10),
+    INIT_CMD(0xcd, 0x08), // 用565时屏蔽    666打开
+    INIT_CMD(0xb0, 0x00, 0x11, 0x16, 0x0e, 0x11, 0x06, 0x05, 0x09, 0x08, 0x21, 0x06, 0x13, 0x10, 0x29, 0x31, 0x18),
+    INIT_CMD(0xb1, 0x00, 0x11, 0x16, 0x0e, 0x11, 0x07, 0x05, 0x09, 0x09, 0x21, 0x05, 0x13, 0x11, 0x2a, 0x31, 0x18),
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x11),
+    INIT_CMD(0xb0, 0x6d),
+    INIT_CMD(0xb1, 0x37),
+    INIT_CMD(0xb2, 0x81),
+    INIT_CMD(0xb3, 0x80),
+    INIT_CMD(0xb5, 0x43),
+    INIT_CMD(0xb7, 0x85),
+    INIT_CMD(0xb8, 0x20),
+    INIT_CMD(0xc1, 0x78),
+    INIT_CMD(0xc2, 0x78),
+    INIT_CMD(0xc3, 0x8c),
+    INIT_CMD(0xd0, 0x88),
+    INIT_CMD(0xe0, 0x00, 0x00, 0x02),
+    INIT_CMD(0xe1, 0x03, 0xa0, 0x00, 0x00, 0x04, 0xa0, 0x00, 0x00, 0x00, 0x20, 0x20),
+    INIT_CMD(0xe2, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00),
+    INIT_CMD(0xe3, 0x00, 0x00, 0x11, 0x00),
+    INIT_CMD(0xe4, 0x22, 0x00),
+    INIT_CMD(0xe5, 0x05, 0xec, 0xa0, 0xa0, 0x07, 0xee, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00),
+    INIT_CMD(0xe6, 0x00, 0x00, 0x11, 0x00),
+    INIT_CMD(0xe7, 0x22, 0x00),
+    INIT_CMD(0xe8, 0x06, 0xed, 0xa0, 0xa0, 0x08, 0xef, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00),
+    INIT_CMD(0xeb, 0x00, 0x00, 0x40, 0x40, 0x00, 0x00, 0x00),
+    INIT_CMD(0xed, 0xff, 0xff, 0xff, 0xba, 0x0a, 0xbf, 0x45, 0xff, 0xff, 0x54, 0xfb, 0xa0, 0xab, 0xff, 0xff, 0xff),
+    INIT_CMD(0xef, 0x10, 0x0d, 0x04, 0x08, 0x3f, 0x1f),
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x13),
+    INIT_CMD(0xef, 0x08),
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x00),
+    INIT_CMD(0x36, 0x08),
+    INIT_CMD(0x3a, 0x66),
+    INIT_CMD0_DELAY(0x11, 100),
+    // INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x12),
+    // INIT_CMD(0xd1, 0x81),
+    // INIT_CMD(0xd2, 0x06),
+    INIT_CMD0_DELAY(0x29, 100),
+    INIT_SEQ_END
 };
 
-const lcd_cmd_t st7701_2_8_inches[ST7701_2_8_INIT_SEQUENCE_LENGHT] = {
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x13}, 0x05},
-    {0xEF, {0x08}, 0x01},
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x10}, 0x05},
-    {0xC0, {0x3B, 0X00}, 0x02},
-    {0xC1, {0x10, 0x0C}, 0x02},
-    {0xC2, {0x07, 0x0A}, 0x02},
-    {0xC7, {0x00}, 0x01},
-    {0xCC, {0x10}, 0x01},
-    {0xCD, {0x08}, 0x01}, // 用565时屏蔽    666打开
-    {0xb0, {0x05, 0x12, 0x98, 0x0e, 0x0F, 0x07, 0x07, 0x09, 0x09, 0x23, 0x05, 0x52, 0x0F, 0x67, 0x2C, 0x11}, 0x10},
-    {0xb1, {0x0B, 0x11, 0x97, 0x0C, 0x12, 0x06, 0x06, 0x08, 0x08, 0x22, 0x03, 0x51, 0x11, 0x66, 0x2B, 0x0F}, 0x10},
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x11}, 0x05},
-    {0xb0, {0x5d}, 0x01},
-    {0xb1, {0x2D}, 0x01},
-    {0xb2, {0x81}, 0x01},
-    {0xb3, {0x80}, 0x01},
-    {0xb5, {0x4E}, 0x01},
-    {0xb7, {0x85}, 0x01},
-    {0xb8, {0x20}, 0x01},
-    {0xc1, {0x78}, 0x01},
-    {0xc2, {0x78}, 0x01},
-    // {0xc3, {0x8c}, 0x01},
-    {0xd0, {0x88}, 0x01},
-    {0xe0, {0x00, 0x00, 0x02}, 0x03},
-    {0xe1, {0x06, 0x30, 0x08, 0x30, 0x05, 0x30, 0x07, 0x30, 0x00, 0x33, 0x33}, 0x0b},
-    {0xe2, {0x11, 0x11, 0x33, 0x33, 0xf4, 0x00, 0x00, 0x00, 0xf4, 0x00, 0x00, 0x00}, 0x0c},
-    {0xe3, {0x00, 0x00, 0x11, 0x11}, 0x04},
-    {0xe4, {0x44, 0x44}, 0x02},
-    {0xe5, {0x0d, 0xf5, 0x30, 0xf0, 0x0f, 0xf7, 0x30, 0xf0, 0x09, 0xf1, 0x30, 0xf0, 0x0b, 0xf3, 0x30, 0xf0}, 0x10},
-    {0xe6, {0x00, 0x00, 0x11, 0x11}, 0x04},
-    {0xe7, {0x44, 0x44}, 0x02},
-    {0xe8, {0x0c, 0xf4, 0x30, 0xf0, 0x0e, 0xf6, 0x30, 0xf0, 0x08, 0xf0, 0x30, 0xf0, 0x0a, 0xf2, 0x30, 0xf0}, 0x10},
-    {0xe9, {0x36}, 0x01},
-    {0xeb, {0x00, 0x01, 0xe4, 0xe4, 0x44, 0x88, 0x40}, 0x07},
-    {0xed, {0xff, 0x10, 0xaf, 0x76, 0x54, 0x2b, 0xcf, 0xff, 0xff, 0xfc, 0xb2, 0x45, 0x67, 0xfa, 0x01, 0xff}, 0x10},
-    {0xef, {0x08, 0x08, 0x08, 0x45, 0x3f, 0x54}, 0x06},
-    {0xFF, {0x77, 0x01, 0x00, 0x00, 0x00}, 0x05},
-
-    {0x11, {0x00}, 0x80},
-    {0x3a, {0x66}, 0x01},
-    {0x36, {0x08}, 0x01},
-    {0x35, {0x00}, 0x01},
-    {0x29, {0x00}, 0x80},
-    {0, {0}, 0xff}
+const uint8_t st7701_2_8_inches[] = {
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x13),
+    INIT_CMD(0xef, 0x08),
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x10),
+    INIT_CMD(0xc0, 0x3b, 0x00),
+    INIT_CMD(0xc1, 0x10, 0x0c),
+    INIT_CMD(0xc2, 0x07, 0x0a),
+    INIT_CMD(0xc7, 0x00),
+    INIT_CMD(0xcc, 0x10),
+    INIT_CMD(0xcd, 0x08), // 用565时屏蔽    666打开
+    INIT_CMD(0xb0, 0x05, 0x12, 0x98, 0x0e, 0x0f, 0x07, 0x07, 0x09, 0x09, 0x23, 0x05, 0x52, 0x0f, 0x67, 0x2c, 0x11),
+    INIT_CMD(0xb1, 0x0b, 0x11, 0x97, 0x0c, 0x12, 0x06, 0x06, 0x08, 0x08, 0x22, 0x03, 0x51, 0x11, 0x66, 0x2b, 0x0f),
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x11),
+    INIT_CMD(0xb0, 0x5d),
+    INIT_CMD(0xb1, 0x2d),
+    INIT_CMD(0xb2, 0x81),
+    INIT_CMD(0xb3, 0x80),
+    INIT_CMD(0xb5, 0x4e),
+    INIT_CMD(0xb7, 0x85),
+    INIT_CMD(0xb8, 0x20),
+    INIT_CMD(0xc1, 0x78),
+    INIT_CMD(0xc2, 0x78),
+    // INIT_CMD(0xc3, 0x8c),
+    INIT_CMD(0xd0, 0x88),
+    INIT_CMD(0xe0, 0x00, 0x00, 0x02),
+    INIT_CMD(0xe1, 0x06, 0x30, 0x08, 0x30, 0x05, 0x30, 0x07, 0x30, 0x00, 0x33, 0x33),
+    INIT_CMD(0xe2, 0x11, 0x11, 0x33, 0x33, 0xf4, 0x00, 0x00, 0x00, 0xf4, 0x00, 0x00, 0x00),
+    INIT_CMD(0xe3, 0x00, 0x00, 0x11, 0x11),
+    INIT_CMD(0xe4, 0x44, 0x44),
+    INIT_CMD(0xe5, 0x0d, 0xf5, 0x30, 0xf0, 0x0f, 0xf7, 0x30, 0xf0, 0x09, 0xf1, 0x30, 0xf0, 0x0b, 0xf3, 0x30, 0xf0),
+    INIT_CMD(0xe6, 0x00, 0x00, 0x11, 0x11),
+    INIT_CMD(0xe7, 0x44, 0x44),
+    INIT_CMD(0xe8, 0x0c, 0xf4, 0x30, 0xf0, 0x0e, 0xf6, 0x30, 0xf0, 0x08, 0xf0, 0x30, 0xf0, 0x0a, 0xf2, 0x30, 0xf0),
+    INIT_CMD(0xe9, 0x36),
+    INIT_CMD(0xeb, 0x00, 0x01, 0xe4, 0xe4, 0x44, 0x88, 0x40),
+    INIT_CMD(0xed, 0xff, 0x10, 0xaf, 0x76, 0x54, 0x2b, 0xcf, 0xff, 0xff, 0xfc, 0xb2, 0x45, 0x67, 0xfa, 0x01, 0xff),
+    INIT_CMD(0xef, 0x08, 0x08, 0x08, 0x45, 0x3f, 0x54),
+    INIT_CMD(0xff, 0x77, 0x01, 0x00, 0x00, 0x00),
+
+    INIT_CMD0_DELAY(0x11, 100),
+    INIT_CMD(0x3a, 0x66),
+    INIT_CMD(0x36, 0x08),
+    INIT_CMD(0x35, 0x00),
+    INIT_CMD0_DELAY(0x29, 100),
+    INIT_SEQ_END
 };
 
 
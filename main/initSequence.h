@@ -9,7 +9,10 @@
 #pragma once
 
 #include <stdint.h>
+#include "init_seq.h"
 
+// A single command built at run time, the init sequences below are
+// init_seq.h byte streams
 typedef struct {
     uint32_t addr;
     uint8_t param[20];
@@ -18,33 +21,27 @@ typedef struct {
 
 #define AMOLED_DEFAULT_BRIGHTNESS               175
 
-#define SH8501_INIT_SEQUENCE_LENGHT             407
-extern const lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGHT];
+extern const uint8_t sh8501_cmd[];
 #define SH8501_WIDTH                            194
 #define SH8501_HEIGHT                           368
 
 
-#define RM67162_INIT_SEQUENCE_LENGHT             6
-extern const lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGHT];
+extern const uint8_t rm67162_cmd[];
 #define RM67162_WIDTH                            240
 #define RM67162_HEIGHT                           536
 
-#define RM690B0_INIT_SEQUENCE_LENGHT             13
-extern const lcd_cmd_t rm690b0_cmd[RM690B0_INIT_SEQUENCE_LENGHT];
+extern const uint8_t rm690b0_cmd[];
 #define RM690B0_WIDTH                            600
 #define RM690B0_HEIGHT                           450
 
 
-#define JD9613_INIT_SEQUENCE_LENGHT             88
-extern const lcd_cmd_t jd9613_cmd[JD9613_INIT_SEQUENCE_LENGHT];
+extern const uint8_t jd9613_cmd[];
 #define JD9613_WIDTH                            126
 #define JD9613_HEIGHT                           294
 
-#define ST7701_2_1_INIT_SEQUENCE_LENGHT             40
-extern const lcd_cmd_t st7701_2_1_inches[ST7701_2_1_INIT_SEQUENCE_LENGHT];
+extern const uint8_t st7701_2_1_inches[];
 
-#define ST7701_2_8_INIT_SEQUENCE_LENGHT             42
-extern const lcd_cmd_t st7701_2_8_inches[ST7701_2_8_INIT_SEQUENCE_LENGHT];
+extern const uint8_t st7701_2_8_inches[];
 
 
 
@@ -0,0 +1,43 @@
+/**
+ * @file      init_seq.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "init_seq.h"
+
+void init_seq_run(const uint8_t *seq, init_seq_write_t write, init_seq_sync_t sync,
+                  init_seq_stats_t *stats)
+{
+    init_seq_stats_t s = {0};
+
+    while (seq[1] != INIT_SEQ_END_LEN) {
+        uint8_t cmd = seq[0];
+        uint8_t len = seq[1] & INIT_SEQ_LEN_MASK;
+        bool wait = seq[1] & INIT_SEQ_DELAY;
+        write(cmd, &seq[2], len);
+        seq += 2 + len;
+        s.cmds++;
+        s.bytes += len;
+        if (wait) {
+            if (sync) {
+                sync();
+            }
+            vTaskDelay(pdMS_TO_TICKS(*seq));
+            s.delay_ms += *seq;
+            seq++;
+        }
+    }
+    if (sync) {
+        sync();
+    }
+    if (stats) {
+        *stats = s;
+    }
+}
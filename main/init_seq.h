@@ -0,0 +1,77 @@
+/**
+ * @file      init_seq.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Panel init sequences are packed byte streams, one entry per command:
+ *
+ *   cmd, len [, param ...] [, delay]
+ *
+ * The low six bits of len are the number of parameter bytes. With
+ * INIT_SEQ_DELAY set, one more byte follows the parameters, the time in ms
+ * to wait after the command. len INIT_SEQ_END_LEN ends the sequence.
+ *
+ * Write the tables with the macros below, they count the parameters:
+ *
+ *   INIT_CMD(0x3A, 0x55),
+ *   INIT_CMD0_DELAY(0x11, 120),
+ *   INIT_SEQ_END
+ */
+#define INIT_SEQ_DELAY          (0x80)
+#define INIT_SEQ_LEN_MASK       (0x3F)
+#define INIT_SEQ_END_LEN        (0xFF)
+
+#define INIT_SEQ_COUNT(...)     (sizeof((const uint8_t[]){__VA_ARGS__}))
+
+#define INIT_CMD(cmd, ...)              (cmd), INIT_SEQ_COUNT(__VA_ARGS__), __VA_ARGS__
+#define INIT_CMD_DELAY(cmd, ms, ...)    (cmd), INIT_SEQ_COUNT(__VA_ARGS__) | INIT_SEQ_DELAY, __VA_ARGS__, (ms)
+#define INIT_CMD0(cmd)                  (cmd), 0
+#define INIT_CMD0_DELAY(cmd, ms)        (cmd), INIT_SEQ_DELAY, (ms)
+#define INIT_SEQ_END                    0x00, INIT_SEQ_END_LEN
+
+/**
+ * @brief Send one command, param points into the sequence itself
+ *
+ * The sequence is static, so a backend may queue the command and keep
+ * using param until the next sync.
+ */
+typedef void (*init_seq_write_t)(uint8_t cmd, const uint8_t *param, uint8_t len);
+
+/**
+ * @brief Wait until all commands written so far have reached the panel
+ */
+typedef void (*init_seq_sync_t)(void);
+
+typedef struct {
+    uint32_t cmds;              // commands sent
+    uint32_t bytes;             // parameter bytes sent
+    uint32_t delay_ms;          // time spent in the delays of the sequence
+} init_seq_stats_t;
+
+/**
+ * @brief Send an init sequence
+ *
+ * Commands are handed to write back to back, sync (may be NULL) is only
+ * called before a delay and at the end. Backends with a transaction queue
+ * can therefore keep the whole run between two delays in flight.
+ *
+ * @param stats  optional, filled in when not NULL
+ */
+void init_seq_run(const uint8_t *seq, init_seq_write_t write, init_seq_sync_t sync,
+                  init_seq_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file      latency_trace.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "product_pins.h"
+#include "touch_driver.h"
+#include "latency_trace.h"
+
+#if CONFIG_LILYGO_LATENCY_TRACE
+
+static const char *TAG = "LATENCY";
+
+// A sample that has not caused a refresh by then did not change the screen
+#define TRACE_RENDER_TIMEOUT_US     (100 * 1000)
+// A trace still open after this long lost its refresh, start over
+#define TRACE_ABANDON_US            (1000 * 1000)
+
+typedef enum {
+    TRACE_IDLE,
+    TRACE_INPUT,                    // sample consumed, waiting for a refresh
+    TRACE_RENDER,                   // refresh started, waiting for its first flush
+    TRACE_FLUSH,                    // waiting for the last area to be sent
+} trace_state_t;
+
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile trace_state_t state = TRACE_IDLE;
+static int64_t sample_us;
+static uint32_t stage_us[LATENCY_STAGE_MAX];
+
+// Per stage ring of the latest traces
+static uint32_t samples[LATENCY_STAGE_MAX][LATENCY_TRACE_SAMPLES];
+static uint32_t traces = 0;
+static uint32_t no_redraw = 0;
+static uint32_t abandoned = 0;
+
+void latency_trace_input(int64_t sample)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&trace_lock);
+    if (state == TRACE_INPUT && now - sample_us - stage_us[LATENCY_STAGE_INDEV] > TRACE_RENDER_TIMEOUT_US) {
+        state = TRACE_IDLE;
+        no_redraw++;
+    } else if (state != TRACE_IDLE && now - sample_us > TRACE_ABANDON_US) {
+        state = TRACE_IDLE;
+        abandoned++;
+    }
+    if (state == TRACE_IDLE) {
+        sample_us = sample;
+        stage_us[LATENCY_STAGE_INDEV] = now - sample;
+        state = TRACE_INPUT;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+void latency_trace_render_start(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&trace_lock);
+    if (state == TRACE_INPUT) {
+        stage_us[LATENCY_STAGE_RENDER] = now - sample_us;
+        state = TRACE_RENDER;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+void latency_trace_flush(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&trace_lock);
+    if (state == TRACE_RENDER) {
+        stage_us[LATENCY_STAGE_FLUSH] = now - sample_us;
+        state = TRACE_FLUSH;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+void IRAM_ATTR latency_trace_flush_done(bool last)
+{
+    if (!last || state != TRACE_FLUSH) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_SAFE(&trace_lock);
+    if (state == TRACE_FLUSH) {
+        stage_us[LATENCY_STAGE_PHOTON] = now - sample_us;
+        uint32_t slot = traces % LATENCY_TRACE_SAMPLES;
+        for (int i = 0; i < LATENCY_STAGE_MAX; i++) {
+            samples[i][slot] = stage_us[i];
+        }
+        traces++;
+        state = TRACE_IDLE;
+    }
+    portEXIT_CRITICAL_SAFE(&trace_lock);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+void latency_trace_get(latency_stage_t stage, latency_stats_t *stats)
+{
+    static uint32_t sorted[LATENCY_TRACE_SAMPLES];
+
+    portENTER_CRITICAL(&trace_lock);
+    uint32_t count = traces;
+    uint32_t n = count < LATENCY_TRACE_SAMPLES ? count : LATENCY_TRACE_SAMPLES;
+    memcpy(sorted, samples[stage], n * sizeof(sorted[0]));
+    portEXIT_CRITICAL(&trace_lock);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->count = count;
+    if (!n) {
+        return;
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_u32);
+    stats->p50 = sorted[n * 50 / 100];
+    stats->p90 = sorted[n * 90 / 100];
+    stats->p99 = sorted[n * 99 / 100];
+    stats->max = sorted[n - 1];
+}
+
+void latency_trace_dump(void)
+{
+    static const char *const names[LATENCY_STAGE_MAX] = {
+        "indev", "render", "flush", "photon"
+    };
+
+    ESP_LOGI(TAG, "%s %dx%d: %lu traces, %lu without redraw, %lu abandoned",
+             CONFIG_IDF_TARGET, AMOLED_HEIGHT, AMOLED_WIDTH, (unsigned long)traces,
+             (unsigned long)no_redraw, (unsigned long)abandoned);
+    for (int i = 0; i < LATENCY_STAGE_MAX; i++) {
+        latency_stats_t s;
+        latency_trace_get((latency_stage_t)i, &s);
+        ESP_LOGI(TAG, "%-7s us p50=%lu p90=%lu p99=%lu max=%lu", names[i],
+                 (unsigned long)s.p50, (unsigned long)s.p90,
+                 (unsigned long)s.p99, (unsigned long)s.max);
+    }
+}
+
+#if CONFIG_LILYGO_LATENCY_TRACE_INTERVAL > 0
+static void latency_trace_timer_cb(void *arg)
+{
+    latency_trace_dump();
+}
+#endif
+
+#if CONFIG_LILYGO_LATENCY_TRACE_INJECT
+#define INJECT_STEPS        (10)
+#define INJECT_STEP_PX      (8)
+
+// A vertical swipe over the middle of the screen, scrolling whatever list
+// is shown, fed through the same ring as the controller samples
+static void latency_inject_task(void *arg)
+{
+    const int16_t x = AMOLED_HEIGHT / 2;
+    int16_t y0 = AMOLED_WIDTH * 3 / 4;
+    int dir = -1;
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_LILYGO_LATENCY_TRACE_INJECT_PERIOD_MS));
+        int16_t y = y0;
+        for (int i = 0; i < INJECT_STEPS; i++) {
+            touch_inject_point(x, y, true);
+            y += dir * INJECT_STEP_PX;
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_LILYGO_TOUCH_HOLD_POLL_MS));
+        }
+        touch_inject_point(x, y, false);
+        // Swipe back the next time, the list stays in range
+        y0 = y;
+        dir = -dir;
+    }
+}
+#endif
+
+void latency_trace_init(void)
+{
+#if CONFIG_LILYGO_LATENCY_TRACE_INTERVAL > 0
+    const esp_timer_create_args_t args = {
+        .callback = &latency_trace_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "latency",
+        .skip_unhandled_events = true
+    };
+    esp_timer_handle_t timer = NULL;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_LILYGO_LATENCY_TRACE_INTERVAL * 1000000ULL));
+#endif
+#if CONFIG_LILYGO_LATENCY_TRACE_INJECT
+    xTaskCreate(latency_inject_task, "lat_inject", 2048, NULL, 1, NULL);
+    ESP_LOGW(TAG, "Injecting a synthetic swipe every %d ms", CONFIG_LILYGO_LATENCY_TRACE_INJECT_PERIOD_MS);
+#endif
+}
+
+#endif
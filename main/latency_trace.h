@@ -0,0 +1,76 @@
+/**
+ * @file      latency_trace.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <sdkconfig.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Last this many traces are kept per stage for the percentiles
+#define LATENCY_TRACE_SAMPLES       (128)
+
+typedef enum {
+    LATENCY_STAGE_INDEV,            // sample read until LVGL consumed it
+    LATENCY_STAGE_RENDER,           // ... until LVGL started the refresh it caused
+    LATENCY_STAGE_FLUSH,            // ... until the first area was handed to the backend
+    LATENCY_STAGE_PHOTON,           // ... until the last area of that refresh was sent
+    LATENCY_STAGE_MAX,
+} latency_stage_t;
+
+typedef struct {
+    uint32_t count;                 // traces recorded in total
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+} latency_stats_t;
+
+#if CONFIG_LILYGO_LATENCY_TRACE
+/*
+ * One touch sample at a time is followed from the touch task to the panel.
+ * A trace starts when LVGL consumes a sample while no other trace is in
+ * flight. The next refresh is attributed to it, unless none starts within
+ * 100 ms, then the sample did not change the screen.
+ */
+
+// Called from the LVGL read callback for every sample it consumes
+void latency_trace_input(int64_t sample_us);
+
+// Called from LVGL's render_start_cb
+void latency_trace_render_start(void);
+
+// Called from the flush callback
+void latency_trace_flush(void);
+
+// Called when the backend is done with an area, safe from an ISR
+void latency_trace_flush_done(bool last);
+
+// Percentiles of the kept traces, in us
+void latency_trace_get(latency_stage_t stage, latency_stats_t *stats);
+
+void latency_trace_dump(void);
+
+// Reports every CONFIG_LILYGO_LATENCY_TRACE_INTERVAL seconds and starts the
+// synthetic swipes with CONFIG_LILYGO_LATENCY_TRACE_INJECT
+void latency_trace_init(void);
+#else
+static inline void latency_trace_input(int64_t sample_us) {}
+static inline void latency_trace_render_start(void) {}
+static inline void latency_trace_flush(void) {}
+static inline void latency_trace_flush_done(bool last) {}
+static inline void latency_trace_init(void) {}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,11 +24,22 @@
 #include "touch_driver.h"
 #include "i2c_driver.h"
 #include "power_driver.h"
+#include "power_telemetry.h"
 #include "demos/lv_demos.h"
 #include "tft_driver.h"
+#include "display_batch.h"
+#include "display_metrics.h"
+#include "latency_trace.h"
+#include "display_pipeline.h"
+#include "display_convert.h"
+#include "display_buffers.h"
 #include "product_pins.h"
+#include "panel_traits.hpp"
+#include "panel_flush.h"
 
 #include "wifi_scanner.h"
+#include "ui_queue.h"
+#include "boot_profile.h"
 
 
 static const char *TAG = "main";
@@ -39,7 +50,19 @@ static const char *TAG = "main";
 #define EXAMPLE_LVGL_TASK_STACK_SIZE (4 * 1024)
 #define EXAMPLE_LVGL_TASK_PRIORITY 2
 
+// Reasons to run lv_timer_handler() before the next LVGL timer is due
+#define LVGL_WAKE_FLUSH     (1 << 0)    // a flush finished
+#define LVGL_WAKE_TOUCH     (1 << 1)    // the touch controller raised its IRQ
+#define LVGL_WAKE_UPDATE    (1 << 2)    // another task changed the UI
+
 static SemaphoreHandle_t lvgl_mux = NULL;
+static TaskHandle_t lvgl_task = NULL;
+// Given once per finished flush for example_lvgl_wait_cb(), apart from the
+// task notification so that waiting for the bus never eats a wakeup
+static SemaphoreHandle_t flush_done_sem = NULL;
+#if BOARD_HAS_TOUCH
+static lv_indev_t *touch_indev = NULL;
+#endif
 
 static lv_disp_draw_buf_t disp_buf; // contains internal graphic buffer(s) called draw buffer(s)
 
@@ -48,29 +71,178 @@ extern "C" {
 }
 
 
+static void IRAM_ATTR example_lvgl_wakeup(uint32_t reason)
+{
+    if (!lvgl_task) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyFromISR(lvgl_task, reason, eSetBits, &woken);
+        if (woken == pdTRUE) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        xTaskNotify(lvgl_task, reason, eSetBits);
+    }
+}
+
+// Other tasks posted to the UI queue
+static void example_lvgl_ui_notify(void)
+{
+    example_lvgl_wakeup(LVGL_WAKE_UPDATE);
+}
+
+// Every backend reports a finished flush here, possibly from an ISR
+extern "C" void IRAM_ATTR display_flush_ready(void)
+{
+    static bool first_frame = false;
+    if (!first_frame && disp_drv.draw_buf->flushing_last) {
+        first_frame = true;
+        boot_profile_mark(DRAM_STR("first frame"));
+    }
+    display_metrics_flush_end();
+    latency_trace_flush_done(disp_drv.draw_buf->flushing_last);
+    lv_disp_flush_ready(&disp_drv);
+    if (flush_done_sem) {
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            xSemaphoreGiveFromISR(flush_done_sem, &woken);
+            if (woken == pdTRUE) {
+                portYIELD_FROM_ISR();
+            }
+        } else {
+            xSemaphoreGive(flush_done_sem);
+        }
+    }
+    example_lvgl_wakeup(LVGL_WAKE_FLUSH);
+}
+
+// The refresh being rendered redraws the whole screen, its first flush is
+// the one panel_flush_set_frame() marks as a frame start
+static bool refr_full_screen = false;
+static bool refr_first_flush = false;
+
+static bool example_lvgl_refr_full_screen(lv_disp_drv_t *drv)
+{
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    if (!disp || disp->driver != drv) {
+        return false;
+    }
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        const lv_area_t *a = &disp->inv_areas[i];
+        if (!disp->inv_area_joined[i] && a->x1 <= 0 && a->y1 <= 0 &&
+                a->x2 >= drv->hor_res - 1 && a->y2 >= drv->ver_res - 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void example_lvgl_render_start_cb(lv_disp_drv_t *drv)
+{
+    display_metrics_render_start();
+    latency_trace_render_start();
+#if CONFIG_LILYGO_DISPLAY_BATCH_AREAS
+    display_batch_render_start_cb(drv);
+#endif
+    // With draw buffers smaller than a frame a full screen redraw arrives
+    // in several flushes, none of them the size of the screen
+    refr_full_screen = example_lvgl_refr_full_screen(drv);
+    refr_first_flush = true;
+}
+
+// LVGL spins on this while the previous transfer is still on the bus, sleep
+// until display_flush_ready() instead. A give left over from a flush nobody
+// waited for only makes LVGL check its flushing flag once more.
+static void example_lvgl_wait_cb(lv_disp_drv_t *drv)
+{
+    display_metrics_wait();
+    if (flush_done_sem) {
+        xSemaphoreTake(flush_done_sem, 1);
+    }
+}
+
+template <class Panel>
 static void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
-#if DISPLAY_FULLRESH
-    uint32_t w = ( area->x2 - area->x1 + 1 );
-    uint32_t h = ( area->y2 - area->y1 + 1 );
-    display_push_colors(area->x1, area->y1, w, h, (uint16_t *)color_map);
-    lv_disp_flush_ready( drv );
+    uint32_t pixels = lv_area_get_size(area);
+    display_metrics_flush_begin(pixels, pixels * DISPLAY_PANEL_BYTES_PER_PIXEL);
+    latency_trace_flush();
+    bool frame_start = refr_first_flush && refr_full_screen;
+    bool frame_end = drv->draw_buf->flushing_last;
+    refr_first_flush = false;
+#if !CONFIG_LILYGO_DISPLAY_PIPELINE
+    // With the pipeline the flush worker converts
+    color_map = (lv_color_t *)display_convert((uint16_t *)color_map, pixels);
+#endif
+    uint16_t x = area->x1;
+    uint16_t y = area->y1;
+    uint16_t w, h;
+    if constexpr (Panel::window == PanelWindow::Extent) {
+        w = area->x2 - area->x1 + 1;
+        h = area->y2 - area->y1 + 1;
+    } else {
+        w = area->x2 + 1;
+        h = area->y2 + 1;
+    }
+    // The driver calls display_flush_ready() once the transfer is done
+#if CONFIG_LILYGO_DISPLAY_PIPELINE
+    display_pipeline_submit(x, y, w, h, (uint16_t *)color_map, pixels, frame_start, frame_end);
 #else
-    int offsetx1 = area->x1;
-    int offsetx2 = area->x2;
-    int offsety1 = area->y1;
-    int offsety2 = area->y2;
-    display_push_colors(offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, (uint16_t *)color_map);
+    panel_flush_set_frame(frame_start, frame_end);
+    display_push_colors(x, y, w, h, (uint16_t *)color_map);
 #endif
 }
 
+// Widen an invalidated area to the window alignment of the panel controller.
+// The Lite rotation maps LVGL rows onto panel columns and AMOLED_WIDTH is
+// even, so the same rule holds in LVGL coordinates. The T4-S3 column offset
+// of 16 keeps the alignment too.
+template <class Panel>
+static void example_lvgl_rounder_cb(lv_disp_drv_t *drv, lv_area_t *area)
+{
+    if constexpr (Panel::align > 1) {
+        area->x1 &= ~(Panel::align - 1);
+        area->y1 &= ~(Panel::align - 1);
+        area->x2 |= Panel::align - 1;
+        area->y2 |= Panel::align - 1;
+    }
+}
+
 
 #if BOARD_HAS_TOUCH
+#if CONFIG_LILYGO_TOUCH_IRQ_TASK
+// The read timer is paused while nothing moves, see example_touch_irq_init()
+static bool touch_event_mode = false;
+
+// The touch task samples the controller, this only drains its ring
 static void example_lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
 {
+    static touch_point_t last = {};
+    touch_point_t point;
+    if (touch_read_point(&point)) {
+        last = point;
+        latency_trace_input(point.time_us);
+        // LVGL advances a scroll throw and sends LV_EVENT_SCROLL_END only on
+        // read cycles after the release, poll until it is done
+        if (!point.pressed && touch_event_mode) {
+            lv_timer_resume(drv->read_timer);
+        }
+        // LVGL calls back right away to process the remaining samples
+        data->continue_reading = touch_points_pending() > 0;
+    }
+    data->point.x = last.x;
+    data->point.y = last.y;
+    data->state = last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+#else
+static void example_lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    static lv_indev_state_t last_state = LV_INDEV_STATE_RELEASED;
     int16_t touchpad_x[1] = {0};
     int16_t touchpad_y[1] = {0};
-    uint8_t touchpad_cnt = 0;
+    int touchpad_cnt = 0;
 
     /* Get coordinates */
     touchpad_cnt = touch_get_data(touchpad_x, touchpad_y, 1);
@@ -79,17 +251,72 @@ static void example_lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
         data->point.x = touchpad_x[0];
         data->point.y = touchpad_y[0];
         data->state = LV_INDEV_STATE_PRESSED;
-    } else {
+    } else if (touchpad_cnt == 0) {
         data->state = LV_INDEV_STATE_RELEASED;
+    } else {
+        // Read failed, LVGL already filled in the last point
+        data->state = last_state;
+    }
+    last_state = data->state;
+}
+#endif
+#endif
+
+#if BOARD_HAS_TOUCH
+#if CONFIG_LILYGO_TOUCH_IRQ_TASK
+static void example_touch_notify(void)
+{
+    example_lvgl_wakeup(LVGL_WAKE_TOUCH);
+}
+
+static void example_touch_irq_init()
+{
+    if (!touch_start_task(example_touch_notify)) {
+        ESP_LOGW(TAG, "Touch task not started");
+        return;
+    }
+    // Event mode, the LVGL task reads the input device when notified
+    lv_timer_pause(touch_indev->driver->read_timer);
+    touch_event_mode = true;
+}
+
+// Back to event mode once the contact is released and no scroll throw is
+// left, LVGL task only
+static void example_touch_idle_check()
+{
+    if (!touch_event_mode || touch_indev->proc.state != LV_INDEV_STATE_RELEASED ||
+            touch_indev->proc.types.pointer.scroll_obj != NULL) {
+        return;
+    }
+    lv_timer_pause(touch_indev->driver->read_timer);
+}
+#else
+static void IRAM_ATTR example_touch_isr(void *arg)
+{
+    example_lvgl_wakeup(LVGL_WAKE_TOUCH);
+}
+
+static void example_touch_irq_init()
+{
+    // Only used as a wakeup, the touch driver still reads the controller
+    gpio_set_intr_type((gpio_num_t)BOARD_TOUCH_IRQ, GPIO_INTR_NEGEDGE);
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Touch IRQ unavailable, touch is polled");
+        return;
     }
+    gpio_isr_handler_add((gpio_num_t)BOARD_TOUCH_IRQ, example_touch_isr, NULL);
 }
 #endif
+#endif
 
+#if !CONFIG_LV_TICK_CUSTOM
 static void example_increase_lvgl_tick(void *arg)
 {
     /* Tell LVGL how many milliseconds has elapsed */
     lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
 }
+#endif
 
 bool example_lvgl_lock(int timeout_ms)
 {
@@ -102,6 +329,10 @@ bool example_lvgl_lock(int timeout_ms)
 void example_lvgl_unlock(void)
 {
     xSemaphoreGiveRecursive(lvgl_mux);
+    // Let the LVGL task pick up changes made from other tasks right away
+    if (xTaskGetCurrentTaskHandle() != lvgl_task) {
+        example_lvgl_wakeup(LVGL_WAKE_UPDATE);
+    }
 }
 
 static void example_lvgl_port_task(void *arg)
@@ -109,9 +340,27 @@ static void example_lvgl_port_task(void *arg)
     ESP_LOGI(TAG, "Starting LVGL task");
     uint32_t task_delay_ms = EXAMPLE_LVGL_TASK_MAX_DELAY_MS;
     while (1) {
+        uint32_t wake = ulTaskNotifyValueClear(NULL, UINT32_MAX);
         // Lock the mutex due to the LVGL APIs are not thread-safe
         if (example_lvgl_lock(-1)) {
+#if BOARD_HAS_TOUCH
+            if ((wake & LVGL_WAKE_TOUCH) && touch_indev && touch_indev->driver->read_timer) {
+#if CONFIG_LILYGO_TOUCH_IRQ_TASK
+                // New samples in the touch ring
+                lv_indev_read_timer_cb(touch_indev->driver->read_timer);
+#else
+                // Read the touch controller now instead of at its next poll
+                lv_timer_ready(touch_indev->driver->read_timer);
+#endif
+            }
+#endif
+            ui_queue_drain(CONFIG_UI_QUEUE_LENGTH);
+            int64_t start = esp_timer_get_time();
             task_delay_ms = lv_timer_handler();
+            display_metrics_timer_handler(esp_timer_get_time() - start);
+#if BOARD_HAS_TOUCH && CONFIG_LILYGO_TOUCH_IRQ_TASK
+            example_touch_idle_check();
+#endif
             // Release the mutex
             example_lvgl_unlock();
         }
@@ -120,7 +369,9 @@ static void example_lvgl_port_task(void *arg)
         } else if (task_delay_ms < EXAMPLE_LVGL_TASK_MIN_DELAY_MS) {
             task_delay_ms = EXAMPLE_LVGL_TASK_MIN_DELAY_MS;
         }
-        vTaskDelay(pdMS_TO_TICKS(task_delay_ms));
+        // Sleep until the next LVGL timer is due, or until a flush, touch or
+        // UI update notification arrives
+        xTaskNotifyWait(0, 0, NULL, pdMS_TO_TICKS(task_delay_ms));
     }
 }
 extern "C" {
@@ -129,64 +380,82 @@ extern "C" {
 
 extern "C" void app_main(void)
 {
+    boot_profile_init();
 
     ESP_LOGI(TAG, "------ Initialize I2C.");
     i2c_driver_init();
+    boot_profile_mark("i2c");
 
     ESP_LOGI(TAG, "------ Initialize PMU.");
     if (!power_driver_init()) {
         ESP_LOGE(TAG, "ERROR :No find PMU ....");
+    } else {
+        power_telemetry_start();
     }
+    boot_profile_mark("pmu");
+
+    // Devices on PMU rails only answer from here on
+    i2c_drv_discover();
+    boot_profile_mark("i2c discovery");
 
     ESP_LOGI(TAG, "------ Initialize TOUCH.");
     touch_init();
+    boot_profile_mark("touch");
 
     ESP_LOGI(TAG, "------ Initialize DISPLAY.");
     display_init();
+    boot_profile_mark("display");
 
 
     ESP_LOGI(TAG, "Initialize LVGL library");
     lv_init();
+    boot_profile_mark("lv_init");
 
 
     // alloc draw buffers used by LVGL
     // it's recommended to choose the size of the draw buffer(s) to be at least 1/10 screen sized
-#if CONFIG_SPIRAM
-
-// #if CONFIG_LILYGO_T_RGB
-//     // initialize LVGL draw buffers
-
-//     extern void *buf1;
-//     extern void *buf2;
-
-//     lv_disp_draw_buf_init(&disp_buf, buf1, buf2, DISPLAY_BUFFER_SIZE);
-// #else
-    lv_color_t *buf1 = (lv_color_t *)heap_caps_malloc(DISPLAY_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
-    assert(buf1);
-
-    lv_color_t *buf2 = (lv_color_t *)heap_caps_malloc(DISPLAY_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
-    assert(buf2);
-
-    // initialize LVGL draw buffers
-    lv_disp_draw_buf_init(&disp_buf, buf1, buf2, DISPLAY_BUFFER_SIZE);
-// #endif
+#if CONFIG_LILYGO_T_RGB_DIRECT_MODE
+    // The panel's two frame buffers, allocated by display_init()
+    extern void *buf1;
+    extern void *buf2;
+    lv_disp_draw_buf_init(&disp_buf, buf1, buf2, BoardPanel::frame_pixels);
 #else
-    lv_color_t *buf1 = (lv_color_t *)heap_caps_malloc(AMOLED_HEIGHT * 20 * sizeof(lv_color_t), MALLOC_CAP_DMA);
-    assert(buf1);
-    lv_color_t *buf2 = (lv_color_t *) heap_caps_malloc(AMOLED_HEIGHT * 20 * sizeof(lv_color_t), MALLOC_CAP_DMA);
-    assert(buf2);
-    lv_disp_draw_buf_init(&disp_buf, buf1, buf2, AMOLED_HEIGHT * 20);
+    // Internal SRAM when there is room for them, PSRAM otherwise
+    void *buf1 = NULL;
+    void *buf2 = NULL;
+    uint32_t buf_pixels = display_alloc_draw_buffers(&buf1, &buf2, BoardPanel::max_draw_pixels,
+                          BoardPanel::min_draw_pixels, BoardPanel::hor_res);
+    assert(buf_pixels);
+    lv_disp_draw_buf_init(&disp_buf, buf1, buf2, buf_pixels);
 #endif
+    display_convert_init(disp_buf.size);
+    boot_profile_mark("draw buffers");
 
     ESP_LOGI(TAG, "Register display driver to LVGL");
     lv_disp_drv_init(&disp_drv);
-    disp_drv.hor_res = AMOLED_HEIGHT;
-    disp_drv.ver_res = AMOLED_WIDTH;
-    disp_drv.flush_cb = example_lvgl_flush_cb;
+    disp_drv.hor_res = BoardPanel::hor_res;
+    disp_drv.ver_res = BoardPanel::ver_res;
+    disp_drv.flush_cb = example_lvgl_flush_cb<BoardPanel>;
     disp_drv.draw_buf = &disp_buf;
-    disp_drv.full_refresh = DISPLAY_FULLRESH;
+    disp_drv.render_start_cb = example_lvgl_render_start_cb;
+    disp_drv.wait_cb = example_lvgl_wait_cb;
+#if CONFIG_LILYGO_DISPLAY_PARTIAL_REFRESH
+    disp_drv.rounder_cb = example_lvgl_rounder_cb<BoardPanel>;
+    disp_drv.full_refresh = false;
+#elif CONFIG_LILYGO_T_RGB_DIRECT_MODE
+    disp_drv.direct_mode = true;
+    disp_drv.full_refresh = false;
+#else
+    disp_drv.full_refresh = BoardPanel::full_refresh;
+#endif
     lv_disp_drv_register(&disp_drv);
+    display_metrics_init();
+#if CONFIG_LILYGO_DISPLAY_PIPELINE
+    display_pipeline_init();
+#endif
 
+#if !CONFIG_LV_TICK_CUSTOM
+    // With CONFIG_LV_TICK_CUSTOM LVGL reads esp_timer_get_time() itself
     ESP_LOGI(TAG, "Install LVGL tick timer");
     // Tick interface for LVGL (using esp_timer to generate 2ms periodic event)
     const esp_timer_create_args_t lvgl_tick_timer_args = {
@@ -199,6 +468,7 @@ extern "C" void app_main(void)
     esp_timer_handle_t lvgl_tick_timer = NULL;
     ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
     ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
+#endif
 
 #if BOARD_HAS_TOUCH
     ESP_LOGI(TAG, "Register touch driver to LVGL");
@@ -206,24 +476,31 @@ extern "C" void app_main(void)
     lv_indev_drv_init(&indev_drv);
     indev_drv.type = LV_INDEV_TYPE_POINTER;
     indev_drv.read_cb = example_lvgl_touch_cb;
-    lv_indev_drv_register(&indev_drv);
+    touch_indev = lv_indev_drv_register(&indev_drv);
+    example_touch_irq_init();
+    latency_trace_init();
 #endif
 
     lvgl_mux = xSemaphoreCreateRecursiveMutex();
     assert(lvgl_mux);
+    flush_done_sem = xSemaphoreCreateBinary();
+    assert(flush_done_sem);
 
 
     ESP_LOGI(TAG, "Display LVGL");
-    // Lock the mutex due to the LVGL APIs are not thread-safe
-    if (example_lvgl_lock(-1)) {
-        wifi_scanner();
+    // UI updates from other tasks go through the UI queue instead of the
+    // mutex, the LVGL task applies them before each lv_timer_handler() run
+    ui_queue_set_notify(example_lvgl_ui_notify);
+    wifi_scanner();
+    boot_profile_mark("wifi scanner");
 
-        // Release the mutex
-        example_lvgl_unlock();
-    }
-    // tskIDLE_PRIORITY,
     ESP_LOGI(TAG, "Create LVGL task");
-    // xTaskCreate(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY, NULL);
-    xTaskCreate(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL);
+#if CONFIG_LILYGO_DISPLAY_PIPELINE
+    xTaskCreatePinnedToCore(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY,
+                            &lvgl_task, CONFIG_LILYGO_DISPLAY_PIPELINE_RENDER_CORE);
+#else
+    xTaskCreate(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY, &lvgl_task);
+#endif
+    boot_profile_mark("lvgl task");
 
 }
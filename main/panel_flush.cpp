@@ -0,0 +1,249 @@
+/**
+ * @file      panel_flush.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <assert.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "product_pins.h"
+#include "panel_traits.hpp"
+#include "panel_flush.h"
+#include "amoled_driver.h"
+#include "pixel_ops.h"
+
+static const char *TAG = "FLUSH";
+
+extern "C" void display_flush_ready(void);
+
+static esp_lcd_panel_handle_t lcd_panel = NULL;
+static qspi_panel_t *qspi = NULL;
+
+// Address window the QSPI panel currently has, as sent with CASET/RASET
+static uint16_t win_xs, win_xe, win_ys, win_ye;
+static bool win_valid = false;
+static uint32_t elided_cmds = 0;
+
+// Where the push in flight sits in the LVGL refresh, see
+// panel_flush_set_frame(). LVGL never has more than one flush in flight.
+static bool push_frame_start = false;
+static bool push_frame_end = false;
+static void (*backend_flush_done)(void) = NULL;
+
+// Frames rotated stripe by stripe go through two DMA buffers, one is being
+// sent while the other one is filled
+static uint16_t *stripe_buf[2] = {NULL, NULL};
+
+template <class Panel>
+static void panel_apply_mount(esp_lcd_panel_handle_t panel)
+{
+    if constexpr (Panel::invert) {
+        ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel, true));
+    }
+    if constexpr (Panel::swap_xy) {
+        ESP_ERROR_CHECK(esp_lcd_panel_swap_xy(panel, true));
+    }
+    if constexpr (Panel::mirror_x || Panel::mirror_y) {
+        ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel, Panel::mirror_x, Panel::mirror_y));
+    }
+    // the gap is LCD panel specific, even panels with the same driver IC, can
+    // have different gap value
+    if constexpr (Panel::x_gap || Panel::y_gap) {
+        ESP_ERROR_CHECK(esp_lcd_panel_set_gap(panel, Panel::x_gap, Panel::y_gap));
+    }
+}
+
+static void panel_window_cmd(uint32_t addr, uint16_t start, uint16_t end)
+{
+    uint8_t param[4] = {
+        (uint8_t)((start >> 8) & 0xFF),
+        (uint8_t)(start & 0xFF),
+        (uint8_t)((end >> 8) & 0xFF),
+        (uint8_t)(end & 0xFF)
+    };
+    qspi_panel_queue_cmd(qspi, addr, param, sizeof(param));
+}
+
+template <class Panel>
+static void panel_set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
+{
+    xs += Panel::x_gap;
+    xe += Panel::x_gap;
+    ys += Panel::y_gap;
+    ye += Panel::y_gap;
+
+    // RAMWR is part of the first pixel chunk (qspi_panel_send_chunk()), so only
+    // CASET and RASET are needed, and only when they change. Stripes of the
+    // same width just move the rows. Only a skipped CASET or RASET counts as
+    // elided, RAMWR still goes out with the pixels.
+    if constexpr (Panel::cache_window) {
+        if (win_valid && xs == win_xs && xe == win_xe) {
+            elided_cmds++;
+        } else {
+            panel_window_cmd(0x2A00, xs, xe);
+            win_xs = xs;
+            win_xe = xe;
+        }
+        if (win_valid && ys == win_ys && ye == win_ye) {
+            elided_cmds++;
+        } else {
+            panel_window_cmd(0x2B00, ys, ye);
+            win_ys = ys;
+            win_ye = ye;
+        }
+        win_valid = true;
+    } else {
+        panel_window_cmd(0x2A00, xs, xe);
+        panel_window_cmd(0x2B00, ys, ye);
+    }
+}
+
+template <class Panel>
+static void panel_push_qspi(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+{
+    assert(qspi);
+
+    if constexpr (Panel::rotate_cw) {
+        // Source columns become panel rows, keep the stripe width even so the
+        // rotation can use its 2x2 path
+        uint16_t stripe_cols = (Panel::chunk_pixels / hight) & ~1;
+        if (stripe_cols > width) {
+            stripe_cols = width;
+        }
+        uint16_t _x = AMOLED_WIDTH - (y + hight);
+        uint16_t _y = x;
+        uint16_t _h = width;
+        uint16_t _w = hight;
+        uint32_t stripe = 0;
+
+        // Both stripes may still be on their way to the panel
+        qspi_panel_wait(qspi, 0);
+        pixel_rotate_cw(stripe_buf[0], data, width, hight, 0, stripe_cols);
+        panel_set_window<Panel>(_x, _y, _x + _w - 1, _y + _h - 1);
+        // A full screen redraw starts right behind the TE edge so the
+        // transfer stays ahead of the scan line, partial updates are not gated
+        if constexpr (Panel::te_sync) {
+            if (push_frame_start) {
+                amoled_te_wait();
+            }
+        }
+        for (uint16_t col = 0; col < width; col += stripe_cols, stripe ^= 1) {
+            uint16_t cols = width - col;
+            if (cols > stripe_cols) {
+                cols = stripe_cols;
+            }
+            if (col) {
+                // Only the previous stripe may still be in flight
+                qspi_panel_wait(qspi, 1);
+                pixel_rotate_cw(stripe_buf[stripe], data, width, hight, col, cols);
+            }
+            qspi_panel_send_chunk(qspi, stripe_buf[stripe], (size_t)cols * hight, col == 0, col + cols == width);
+        }
+    } else {
+        panel_set_window<Panel>(x, y, x + width - 1, y + hight - 1);
+        // A full screen redraw starts right behind the TE edge so the
+        // transfer stays ahead of the scan line, partial updates are not gated
+        if constexpr (Panel::te_sync) {
+            if (push_frame_start) {
+                amoled_te_wait();
+            }
+        }
+        // With CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER this returns as soon as
+        // all chunks are queued, LVGL gets notified once the last one is out
+        qspi_panel_push(qspi, data, (uint32_t)width * hight);
+    }
+}
+
+// width and hight follow Panel::window, see example_lvgl_flush_cb()
+template <class Panel>
+static void panel_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+{
+    if constexpr (Panel::bus == PanelBus::Qspi) {
+        panel_push_qspi<Panel>(x, y, width, hight, data);
+    } else {
+        esp_lcd_panel_draw_bitmap(lcd_panel, x, y, width, hight, data);
+        // The RGB panel copies into its frame buffer before returning
+        if constexpr (Panel::bus == PanelBus::Rgb) {
+            display_flush_ready();
+        }
+    }
+}
+
+// The last chunk of a push is out. A TE gated refresh may come in several
+// stripes, the vblanks it overran count up to the end of its last one.
+static void IRAM_ATTR panel_flush_done(void)
+{
+    if constexpr (BoardPanel::te_sync) {
+        if (push_frame_end) {
+            amoled_te_frame_done();
+        }
+    }
+    backend_flush_done();
+}
+
+void panel_flush_attach_lcd(esp_lcd_panel_handle_t panel)
+{
+    lcd_panel = panel;
+    panel_apply_mount<BoardPanel>(panel);
+}
+
+esp_err_t panel_flush_attach_qspi(qspi_panel_t *panel, spi_host_device_t host, int clock_hz,
+                                  int cs_gpio, void (*flush_done)(void))
+{
+    if constexpr (BoardPanel::rotate_cw) {
+        for (int i = 0; i < 2; i++) {
+            stripe_buf[i] = (uint16_t *)heap_caps_malloc(BoardPanel::chunk_pixels * sizeof(uint16_t), MALLOC_CAP_DMA);
+            if (!stripe_buf[i]) {
+                ESP_LOGE(TAG, "No memory for the rotation stripes");
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+    qspi_panel_config_t config = {};
+    config.cs_gpio = cs_gpio;
+    config.chunk_pixels = BoardPanel::chunk_pixels;
+    config.continue_cmd = BoardPanel::ramwr_continue;
+    config.flush_done = panel_flush_done;
+    backend_flush_done = flush_done;
+    esp_err_t ret = qspi_panel_add_device(panel, host, clock_hz, &config);
+    if (ret == ESP_OK) {
+        qspi = panel;
+        // The window after reset is unknown, the first flush sends it in full
+        win_valid = false;
+    }
+    return ret;
+}
+
+void panel_flush_set_frame(bool frame_start, bool frame_end)
+{
+    push_frame_start = frame_start;
+    push_frame_end = frame_end;
+}
+
+uint32_t panel_flush_chunk_pixels(void)
+{
+    return BoardPanel::chunk_pixels;
+}
+
+void panel_flush_set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
+{
+    panel_set_window<BoardPanel>(xs, ys, xe, ye);
+}
+
+uint32_t panel_flush_elided_cmds(void)
+{
+    return elided_cmds;
+}
+
+#if !CONFIG_LILYGO_T_RGB_DIRECT_MODE
+extern "C" void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+{
+    panel_push_colors<BoardPanel>(x, y, width, hight, data);
+}
+#endif
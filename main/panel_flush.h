@@ -0,0 +1,65 @@
+/**
+ * @file      panel_flush.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <sdkconfig.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_panel_ops.h"
+#include "qspi_panel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The one display_push_colors() of all boards, specialized at compile time on
+ * the traits in panel_traits.hpp. The backends bring up their bus and panel
+ * and attach it here, T-RGB in direct mode keeps its own.
+ */
+
+/**
+ * @brief Push through an esp_lcd panel
+ *
+ * Applies the colour inversion, orientation and gap of the board.
+ */
+void panel_flush_attach_lcd(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Add a QSPI panel to an initialized bus and push through it
+ *
+ * Chunk size and framing come from the board traits. flush_done is called
+ * once the last chunk of a push is out, see qspi_panel_config_t.
+ */
+esp_err_t panel_flush_attach_qspi(qspi_panel_t *panel, spi_host_device_t host, int clock_hz,
+                                  int cs_gpio, void (*flush_done)(void));
+
+/**
+ * @brief Tell the next display_push_colors() where it sits in the refresh
+ *
+ * frame_start marks the first area of a refresh that redraws the whole
+ * screen, panels with TE sync start that one on a TE edge. frame_end marks
+ * the last area of the refresh. Call it from the task that pushes, right
+ * before display_push_colors().
+ */
+void panel_flush_set_frame(bool frame_start, bool frame_end);
+
+// Pixels per QSPI transaction, the bus needs room for one
+uint32_t panel_flush_chunk_pixels(void);
+
+// Set the QSPI address window, inclusive panel coordinates without the gap
+void panel_flush_set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+
+// Number of CASET/RASET commands panel_flush_set_window() did not have to send
+uint32_t panel_flush_elided_cmds(void);
+
+#ifdef __cplusplus
+}
+#endif
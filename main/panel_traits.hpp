@@ -0,0 +1,190 @@
+/**
+ * @file      panel_traits.hpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "product_pins.h"
+
+// How the display backend of a board is attached
+enum class PanelBus {
+    Qspi,       // amoled_driver.c, display_long.c
+    I80,        // esp_lcd i80, display_s3.c and display_hmi.c
+    Spi,        // esp_lcd SPI, the remaining display_*.c
+    Rgb,        // esp_lcd RGB, display_rgb.cpp
+};
+
+// What the last two arguments of display_push_colors() mean
+enum class PanelWindow {
+    Extent,     // width and height, the QSPI backends
+    End,        // exclusive end column and row, like esp_lcd_panel_draw_bitmap()
+};
+
+// Properties that follow from the bus and its controllers
+template <PanelBus Bus>
+struct PanelBusTraits {
+    static constexpr PanelWindow window = PanelWindow::End;
+    static constexpr uint16_t align = 1;
+};
+
+// RM67162, SH8501 and RM690B0 need windows that start on an even column and
+// row and end on an odd one. T-Display-Long only ever sends full frames.
+template <>
+struct PanelBusTraits<PanelBus::Qspi> {
+    static constexpr PanelWindow window = PanelWindow::Extent;
+    static constexpr uint16_t align = 2;
+};
+
+#if defined(CONFIG_LILYGO_T_AMOLED_LITE_147) || \
+    defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED) || \
+    defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED_TOUCH) || \
+    defined(CONFIG_LILYGO_T4_S3_241) || \
+    defined(CONFIG_LILYGO_T_Track_102) || \
+    defined(CONFIG_LILYGO_T_DISPLAY_LONG)
+#define BOARD_PANEL_BUS     PanelBus::Qspi
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3) || defined(CONFIG_LILYGO_T_HMI)
+#define BOARD_PANEL_BUS     PanelBus::I80
+#elif defined(CONFIG_LILYGO_T_RGB)
+#define BOARD_PANEL_BUS     PanelBus::Rgb
+#else
+#define BOARD_PANEL_BUS     PanelBus::Spi
+#endif
+
+// How the panel is mounted and fed, one set of constants per board. The gap
+// shifts every window, esp_lcd applies it together with the orientation.
+struct PanelMountDefaults {
+    static constexpr uint16_t x_gap = 0;
+    static constexpr uint16_t y_gap = 0;
+    static constexpr bool invert = false;
+    static constexpr bool swap_xy = false;
+    static constexpr bool mirror_x = false;
+    static constexpr bool mirror_y = false;
+    // QSPI only
+    static constexpr uint32_t chunk_pixels = 16384; // pixels per transaction
+    static constexpr bool rotate_cw = false;        // frames are rotated stripe by stripe
+    static constexpr bool te_sync = false;          // full screen redraws wait for amoled_te_wait()
+    static constexpr bool cache_window = false;     // CASET/RASET only when they change
+    static constexpr bool ramwr_continue = false;   // chunks after the first start with RAMWRC
+};
+
+#if defined(CONFIG_LILYGO_T_AMOLED_LITE_147)
+struct BoardMount : PanelMountDefaults {
+    static constexpr bool rotate_cw = true;
+    static constexpr bool te_sync = true;
+    static constexpr bool cache_window = true;
+};
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED) || defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED_TOUCH)
+struct BoardMount : PanelMountDefaults {
+    static constexpr bool te_sync = true;
+    static constexpr bool cache_window = true;
+};
+#elif defined(CONFIG_LILYGO_T4_S3_241)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t x_gap = 16;
+    static constexpr bool te_sync = true;
+    static constexpr bool cache_window = true;
+};
+#elif defined(CONFIG_LILYGO_T_DISPLAY_LONG)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint32_t chunk_pixels = 14400;
+#if CONFIG_LILYGO_DISPLAY_LONG_HOLD_CS
+    static constexpr bool ramwr_continue = false;
+#else
+    static constexpr bool ramwr_continue = true;
+#endif
+};
+#elif defined(CONFIG_LILYGO_T_DISPLAY)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t x_gap = 40;
+    static constexpr uint16_t y_gap = 53;
+    static constexpr bool invert = true;
+    static constexpr bool swap_xy = true;
+    static constexpr bool mirror_y = true;
+};
+#elif defined(CONFIG_LILYGO_T_DONGLE_S2)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t x_gap = 53;
+    static constexpr uint16_t y_gap = 40;
+    static constexpr bool invert = true;
+};
+#elif defined(CONFIG_LILYGO_T_DONGLE_S3)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t x_gap = 26;
+    static constexpr uint16_t y_gap = 1;
+    static constexpr bool invert = true;
+};
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3)
+// The screen faces you, and the USB is on the left. With the USB to the
+// right it is mirror_x instead of mirror_y.
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t y_gap = 35;
+    static constexpr bool invert = true;
+    static constexpr bool swap_xy = true;
+    static constexpr bool mirror_y = true;
+};
+#elif defined(CONFIG_LILYGO_T_DISPLAY_S3_PRO)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t y_gap = 49;
+    static constexpr bool invert = true;
+    static constexpr bool swap_xy = true;
+};
+#elif defined(CONFIG_LILYGO_T_QT_S3) || defined(CONFIG_LILYGO_T_QT_C6)
+struct BoardMount : PanelMountDefaults {
+    static constexpr uint16_t x_gap = 2;
+    static constexpr uint16_t y_gap = 1;
+    static constexpr bool invert = true;
+    static constexpr bool mirror_x = true;
+    static constexpr bool mirror_y = true;
+};
+#elif defined(CONFIG_LILYGO_T_WATCH_S3) || defined(CONFIG_LILYGO_T_WATCH_2019)
+struct BoardMount : PanelMountDefaults {
+    static constexpr bool invert = true;
+    static constexpr bool mirror_x = true;
+};
+#elif defined(CONFIG_LILYGO_T_HMI)
+struct BoardMount : PanelMountDefaults {
+    static constexpr bool swap_xy = true;
+    static constexpr bool mirror_y = true;
+};
+#else
+// T-RGB, and T-Track whose backend is not part of this tree
+struct BoardMount : PanelMountDefaults {
+};
+#endif
+
+/**
+ * @brief Panel of the selected board as compile time constants
+ *
+ * LVGL coordinates are landscape, hor_res is AMOLED_HEIGHT. Everything here
+ * is constexpr, so code templated on it keeps only the branches of its
+ * board.
+ */
+struct BoardPanel : PanelBusTraits<BOARD_PANEL_BUS>, BoardMount {
+    static constexpr PanelBus bus = BOARD_PANEL_BUS;
+    static constexpr uint16_t hor_res = AMOLED_HEIGHT;
+    static constexpr uint16_t ver_res = AMOLED_WIDTH;
+    static constexpr bool full_refresh = DISPLAY_FULLRESH;
+#if CONFIG_LILYGO_DISPLAY_PARTIAL_REFRESH
+    static constexpr bool partial_refresh = true;
+#else
+    static constexpr bool partial_refresh = false;
+#endif
+#if CONFIG_SPIRAM
+    static constexpr bool psram = true;
+#else
+    static constexpr bool psram = false;
+#endif
+    static constexpr uint32_t frame_pixels = DISPLAY_BUFFER_SIZE;
+    // Full refresh renders whole frames only, otherwise 20 lines will do
+    static constexpr uint32_t min_draw_pixels =
+        full_refresh && !partial_refresh ? frame_pixels : hor_res * 20;
+    static constexpr uint32_t max_draw_pixels = psram ? frame_pixels : hor_res * 20;
+
+    static_assert(align && !(align & (align - 1)), "window alignment must be a power of two");
+    static_assert(!rotate_cw || (chunk_pixels / ver_res) >= 2, "a stripe must hold two columns");
+};
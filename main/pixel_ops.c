@@ -0,0 +1,150 @@
+/**
+ * @file      pixel_ops.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include "pixel_ops.h"
+
+// 16x16 RGB565 pixels are 512 bytes, small enough that the source rows of a
+// tile stay cached while it is being transposed
+#define ROTATE_TILE     (16)
+
+static inline uint16_t min_u16(uint16_t a, uint16_t b)
+{
+    return a < b ? a : b;
+}
+
+// dst(c - col, height - 1 - r) = src(r, c) for the tile at (tx, ty)
+static void rotate_tile(uint16_t *dst, const uint16_t *src, uint16_t width, uint16_t height,
+                        uint16_t col, uint16_t tx, uint16_t tw, uint16_t ty, uint16_t th)
+{
+    for (uint16_t c = tx; c < tx + tw; c++) {
+        const uint16_t *s = src + (uint32_t)(ty + th - 1) * width + c;
+        uint16_t *d = dst + (uint32_t)(c - col) * height + (height - ty - th);
+        for (uint16_t k = 0; k < th; k++) {
+            d[k] = *s;
+            s -= width;
+        }
+    }
+}
+
+// Same as rotate_tile() but moves 2x2 blocks: one 32 bit load per source row
+// pair, one 32 bit store per destination row pair
+static void rotate_tile_2x2(uint16_t *dst, const uint16_t *src, uint16_t width, uint16_t height,
+                            uint16_t col, uint16_t tx, uint16_t tw, uint16_t ty, uint16_t th)
+{
+    const int32_t stride = width / 2;
+    for (uint16_t c = tx; c < tx + tw; c += 2) {
+        const uint32_t *s = (const uint32_t *)(src + (uint32_t)(ty + th - 1) * width + c);
+        uint32_t *d0 = (uint32_t *)(dst + (uint32_t)(c - col) * height + (height - ty - th));
+        uint32_t *d1 = d0 + height / 2;
+        for (uint16_t k = 0; k < th / 2; k++) {
+            uint32_t lo = s[0];         // row r,     pixels c and c + 1
+            uint32_t hi = s[-stride];   // row r - 1, pixels c and c + 1
+            d0[k] = (lo & 0xFFFF) | (hi << 16);
+            d1[k] = (lo >> 16) | (hi & 0xFFFF0000);
+            s -= 2 * stride;
+        }
+    }
+}
+
+void pixel_rotate_cw(uint16_t *dst, const uint16_t *src, uint16_t width, uint16_t height,
+                     uint16_t col, uint16_t cols)
+{
+    bool pairs = !((width | height | col | cols) & 1) &&
+                 !(((uintptr_t)dst | (uintptr_t)src) & 3);
+
+    for (uint16_t tx = col; tx < col + cols; tx += ROTATE_TILE) {
+        uint16_t tw = min_u16(ROTATE_TILE, col + cols - tx);
+        for (uint16_t ty = 0; ty < height; ty += ROTATE_TILE) {
+            uint16_t th = min_u16(ROTATE_TILE, height - ty);
+            if (pairs) {
+                rotate_tile_2x2(dst, src, width, height, col, tx, tw, ty, th);
+            } else {
+                rotate_tile(dst, src, width, height, col, tx, tw, ty, th);
+            }
+        }
+    }
+}
+
+// Swap the bytes of both pixels in a word
+static inline uint32_t swap16x2(uint32_t w)
+{
+    return ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+}
+
+void pixel_swap16(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & 3) == 0) {
+        if (count && ((uintptr_t)src & 3)) {
+            *dst++ = __builtin_bswap16(*src++);
+            count--;
+        }
+        uint32_t *d = (uint32_t *)dst;
+        const uint32_t *s = (const uint32_t *)src;
+        for (; count >= 8; count -= 8) {
+            uint32_t w0 = s[0], w1 = s[1], w2 = s[2], w3 = s[3];
+            d[0] = swap16x2(w0);
+            d[1] = swap16x2(w1);
+            d[2] = swap16x2(w2);
+            d[3] = swap16x2(w3);
+            s += 4;
+            d += 4;
+        }
+        for (; count >= 2; count -= 2) {
+            *d++ = swap16x2(*s++);
+        }
+        dst = (uint16_t *)d;
+        src = (const uint16_t *)s;
+    }
+    while (count--) {
+        *dst++ = __builtin_bswap16(*src++);
+    }
+}
+
+// RGB565 to R, G, B bytes, the low bits repeat the high ones so that full
+// intensity stays full intensity
+static inline uint32_t rgb565_to_888(uint16_t p)
+{
+    uint32_t r = p >> 11, g = (p >> 5) & 0x3F, b = p & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    // Little endian byte order R, G, B
+    return r | (g << 8) | (b << 16);
+}
+
+void pixel_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, uint32_t count, bool swapped)
+{
+    if (!((uintptr_t)dst & 3)) {
+        uint32_t *d = (uint32_t *)dst;
+        for (; count >= 4; count -= 4) {
+            uint16_t p0 = src[0], p1 = src[1], p2 = src[2], p3 = src[3];
+            if (swapped) {
+                p0 = __builtin_bswap16(p0);
+                p1 = __builtin_bswap16(p1);
+                p2 = __builtin_bswap16(p2);
+                p3 = __builtin_bswap16(p3);
+            }
+            uint32_t c0 = rgb565_to_888(p0), c1 = rgb565_to_888(p1);
+            uint32_t c2 = rgb565_to_888(p2), c3 = rgb565_to_888(p3);
+            // R0 G0 B0 R1 | G1 B1 R2 G2 | B2 R3 G3 B3
+            d[0] = c0 | (c1 << 24);
+            d[1] = (c1 >> 8) | (c2 << 16);
+            d[2] = (c2 >> 16) | (c3 << 8);
+            src += 4;
+            d += 3;
+        }
+        dst = (uint8_t *)d;
+    }
+    while (count--) {
+        uint16_t p = *src++;
+        uint32_t c = rgb565_to_888(swapped ? __builtin_bswap16(p) : p);
+        *dst++ = c;
+        *dst++ = c >> 8;
+        *dst++ = c >> 16;
+    }
+}
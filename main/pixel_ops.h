@@ -0,0 +1,54 @@
+/**
+ * @file      pixel_ops.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Rotate RGB565 pixels by 90 degrees clockwise
+ *
+ * Source columns [col, col + cols) of the width x height image in src become
+ * destination rows 0 .. cols - 1. Each destination row is height pixels long,
+ * its first pixel is the bottom pixel of the source column.
+ *
+ * The image is walked in small tiles so that both the column wise reads and
+ * the row wise writes stay within a few cache lines. When width, height, col
+ * and cols are even and both buffers are 32 bit aligned, each tile is moved
+ * as 2x2 pixel blocks with 32 bit loads and stores.
+ */
+void pixel_rotate_cw(uint16_t *dst, const uint16_t *src, uint16_t width, uint16_t height,
+                     uint16_t col, uint16_t cols);
+
+/**
+ * @brief Byte swap RGB565 pixels while copying them
+ *
+ * Converts between LVGL's native pixel order and the big endian order the
+ * panels expect on the wire. dst may be the same buffer as src. Two pixels
+ * are swapped per 32 bit word when both buffers share their alignment.
+ */
+void pixel_swap16(uint16_t *dst, const uint16_t *src, uint32_t count);
+
+/**
+ * @brief Expand RGB565 pixels to RGB666 while copying them
+ *
+ * Every pixel becomes three bytes R, G, B with the component in the upper
+ * six bits, the layout of COLMOD 0x66 on ST77xx controllers. Set swapped
+ * when src holds byte swapped RGB565 (CONFIG_LV_COLOR_16_SWAP). Four pixels
+ * are written as three 32 bit words when dst is 32 bit aligned.
+ */
+void pixel_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, uint32_t count, bool swapped);
+
+#ifdef __cplusplus
+}
+#endif
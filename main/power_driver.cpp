@@ -17,6 +17,18 @@
 
 static const char *TAG = "POWER";
 
+#if CONFIG_PMU_AXP202 || CONFIG_PMU_AXP2101 || CONFIG_PMU_SY6970
+// begin() is the probe for the configured PMU, the topology only records
+// its result
+template <class Pmu>
+static bool power_pmu_begin(Pmu &pmu, uint8_t address)
+{
+    bool ok = pmu.begin(bus_handle, address);
+    i2c_drv_set_device(I2C_DEV_PMU, ok ? address : 0);
+    return ok;
+}
+#endif
+
 #if CONFIG_PMU_AXP202
 
 #include "XPowersAXP202.tpp"
@@ -25,7 +37,7 @@ XPowersAXP202 PMU;
 
 bool power_driver_init()
 {
-    if (PMU.begin(bus_handle, AXP202_SLAVE_ADDRESS)) {
+    if (power_pmu_begin(PMU, AXP202_SLAVE_ADDRESS)) {
         ESP_LOGI(TAG, "Init PMU SUCCESS!");
     } else {
         ESP_LOGE(TAG, "Init PMU FAILED!");
@@ -46,7 +58,7 @@ XPowersAXP2101 PMU;
 
 bool power_driver_init()
 {
-    if (PMU.begin(bus_handle, AXP2101_SLAVE_ADDRESS)) {
+    if (power_pmu_begin(PMU, AXP2101_SLAVE_ADDRESS)) {
         ESP_LOGI(TAG, "Init PMU SUCCESS!");
     } else {
         ESP_LOGE(TAG, "Init PMU FAILED!");
@@ -125,6 +137,14 @@ bool power_driver_init()
     PMU.enableBattVoltageMeasure();
 #endif
 
+#if CONFIG_LILYGO_PMU_TELEMETRY
+    // Read back by power_telemetry.c, the watch branch above leaves them off
+    PMU.enableBattDetection();
+    PMU.enableVbusVoltageMeasure();
+    PMU.enableBattVoltageMeasure();
+    PMU.enableTemperatureMeasure();
+#endif
+
     ESP_LOGI(TAG, "DCDC========================");
     ESP_LOGI(TAG, "DC1  : %s   Voltage:%u mV ",  PMU.isEnableDC1()  ? "+" : "-", PMU.getDC1Voltage());
     ESP_LOGI(TAG, "DC2  : %s   Voltage:%u mV ",  PMU.isEnableDC2()  ? "+" : "-", PMU.getDC2Voltage());
@@ -158,7 +178,7 @@ PowersSY6970 PMU;
 
 bool power_driver_init()
 {
-    if (PMU.begin(bus_handle, SY6970_SLAVE_ADDRESS)) {
+    if (power_pmu_begin(PMU, SY6970_SLAVE_ADDRESS)) {
         ESP_LOGI(TAG, "Init PMU SUCCESS!");
     } else {
         ESP_LOGE(TAG, "Init PMU FAILED!");
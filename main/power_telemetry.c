@@ -0,0 +1,256 @@
+/**
+ * @file      power_telemetry.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "product_pins.h"
+#include "i2c_driver.h"
+#include "i2c_sched.h"
+#include "power_telemetry.h"
+
+#if CONFIG_LILYGO_PMU_TELEMETRY && (CONFIG_PMU_AXP2101 || CONFIG_PMU_SY6970)
+
+static const char *TAG = "TELEMETRY";
+
+#define TELEMETRY_TASK_PRIORITY     (1)
+#define TELEMETRY_TASK_STACK_SIZE   (3 * 1024)
+#define TELEMETRY_WINDOWS           (CONFIG_LILYGO_PMU_TELEMETRY_WINDOWS)
+#define TELEMETRY_DECIMATION        (CONFIG_LILYGO_PMU_TELEMETRY_DECIMATION)
+// A sample that cannot start within this waits for the next period
+#define TELEMETRY_DEADLINE_MS       (50)
+
+static i2c_master_dev_handle_t pmu_dev = NULL;
+static portMUX_TYPE telemetry_lock = portMUX_INITIALIZER_UNLOCKED;
+static power_sample_t latest;
+static bool has_latest = false;
+static uint32_t errors = 0;
+
+// head runs freely, the ring index is taken modulo its size
+static power_window_t windows[TELEMETRY_WINDOWS];
+static uint32_t windows_head = 0;
+
+// Window being filled, owned by the telemetry task
+static struct {
+    uint16_t samples;
+    uint16_t temp_samples;
+    int32_t batt_sum;
+    int32_t vbus_sum;
+    int32_t temp_sum;
+    power_window_t window;
+} acc;
+
+static esp_err_t read_burst(uint8_t reg, uint8_t *buf, size_t len)
+{
+    return i2c_sched_transfer(pmu_dev, I2C_SCHED_PRIO_PMU, &reg, 1, buf, len, TELEMETRY_DEADLINE_MS);
+}
+
+#if CONFIG_PMU_AXP2101
+#define AXP2101_STATUS1             (0x00)
+#define AXP2101_ADC_DATA            (0x34)  // VBAT, TS, VBUS, VSYS, TDIE, high byte first
+
+static inline uint16_t adc_value(const uint8_t *data, uint8_t mask)
+{
+    return ((data[0] & mask) << 8) | data[1];
+}
+
+// Two bursts: status 1 and 2, then the ADC results 0x34 .. 0x3D
+static esp_err_t read_sample(power_sample_t *sample)
+{
+    uint8_t status[2];
+    uint8_t adc[10];
+    esp_err_t ret = read_burst(AXP2101_STATUS1, status, sizeof(status));
+    if (ret == ESP_OK) {
+        ret = read_burst(AXP2101_ADC_DATA, adc, sizeof(adc));
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    static const power_charge_t charge_states[8] = {
+        POWER_CHARGE_PRE, POWER_CHARGE_PRE, POWER_CHARGE_CC, POWER_CHARGE_CV,
+        POWER_CHARGE_DONE, POWER_CHARGE_NONE, POWER_CHARGE_NONE, POWER_CHARGE_NONE
+    };
+    sample->vbus_good = status[0] & (1 << 5);
+    sample->batt_present = status[0] & (1 << 3);
+    sample->charge = charge_states[status[1] & 0x07];
+    sample->batt_mv = sample->batt_present ? adc_value(&adc[0], 0x1F) : 0;
+    sample->vbus_mv = sample->vbus_good ? adc_value(&adc[4], 0x3F) : 0;
+    // 22 degC at 7274, -0.05 degC per LSB
+    sample->temp_dc = 220 + (7274 - (int32_t)adc_value(&adc[8], 0x3F)) / 2;
+    return ESP_OK;
+}
+
+#elif CONFIG_PMU_SY6970
+#define SY6970_STATUS               (0x0B)  // REG0B status .. REG11 VBUS voltage
+
+// One burst from REG0B to REG11
+static esp_err_t read_sample(power_sample_t *sample)
+{
+    uint8_t regs[7];
+    esp_err_t ret = read_burst(SY6970_STATUS, regs, sizeof(regs));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    static const power_charge_t charge_states[4] = {
+        POWER_CHARGE_NONE, POWER_CHARGE_PRE, POWER_CHARGE_CC, POWER_CHARGE_DONE
+    };
+    uint8_t batv = regs[0x0E - SY6970_STATUS] & 0x7F;
+    uint8_t vbusv = regs[0x11 - SY6970_STATUS];
+    sample->charge = charge_states[(regs[0] >> 3) & 0x03];
+    sample->vbus_good = vbusv & 0x80;
+    sample->vbus_mv = sample->vbus_good ? 2600 + (vbusv & 0x7F) * 100 : 0;
+    // The ADC reads its offset without a battery
+    sample->batt_present = batv != 0;
+    sample->batt_mv = sample->batt_present ? 2304 + batv * 20 : 0;
+    sample->temp_dc = POWER_TEMP_UNKNOWN;
+    return ESP_OK;
+}
+#endif
+
+static void stat_add(power_stat_t *stat, int32_t *sum, int32_t value, bool first)
+{
+    if (first || value < stat->min) {
+        stat->min = value;
+    }
+    if (first || value > stat->max) {
+        stat->max = value;
+    }
+    *sum += value;
+}
+
+static void accumulate(const power_sample_t *sample)
+{
+    bool first = acc.samples == 0;
+    stat_add(&acc.window.batt_mv, &acc.batt_sum, sample->batt_mv, first);
+    stat_add(&acc.window.vbus_mv, &acc.vbus_sum, sample->vbus_mv, first);
+    if (sample->temp_dc != POWER_TEMP_UNKNOWN) {
+        stat_add(&acc.window.temp_dc, &acc.temp_sum, sample->temp_dc, acc.temp_samples == 0);
+        acc.temp_samples++;
+    }
+    acc.samples++;
+    acc.window.time_us = sample->time_us;
+    acc.window.charge = sample->charge;
+    if (acc.samples < TELEMETRY_DECIMATION) {
+        return;
+    }
+
+    acc.window.samples = acc.samples;
+    acc.window.batt_mv.avg = acc.batt_sum / acc.samples;
+    acc.window.vbus_mv.avg = acc.vbus_sum / acc.samples;
+    if (acc.temp_samples) {
+        acc.window.temp_dc.avg = acc.temp_sum / acc.temp_samples;
+    } else {
+        acc.window.temp_dc = (power_stat_t) {
+            POWER_TEMP_UNKNOWN, POWER_TEMP_UNKNOWN, POWER_TEMP_UNKNOWN
+        };
+    }
+    portENTER_CRITICAL(&telemetry_lock);
+    windows[windows_head % TELEMETRY_WINDOWS] = acc.window;
+    windows_head++;
+    portEXIT_CRITICAL(&telemetry_lock);
+    memset(&acc, 0, sizeof(acc));
+}
+
+static void telemetry_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        power_sample_t sample = {};
+        sample.time_us = esp_timer_get_time();
+        if (read_sample(&sample) == ESP_OK) {
+            portENTER_CRITICAL(&telemetry_lock);
+            latest = sample;
+            has_latest = true;
+            portEXIT_CRITICAL(&telemetry_lock);
+            accumulate(&sample);
+        } else {
+            portENTER_CRITICAL(&telemetry_lock);
+            errors++;
+            portEXIT_CRITICAL(&telemetry_lock);
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_LILYGO_PMU_TELEMETRY_PERIOD_MS));
+    }
+}
+
+bool power_telemetry_start(void)
+{
+    uint8_t address = i2c_drv_device(I2C_DEV_PMU);
+    if (!address || pmu_dev) {
+        return false;
+    }
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = address,
+        .scl_speed_hz = 400000,
+    };
+    if (i2c_master_bus_add_device(bus_handle, &dev_cfg, &pmu_dev) != ESP_OK) {
+        return false;
+    }
+    xTaskCreate(telemetry_task, "telemetry", TELEMETRY_TASK_STACK_SIZE, NULL, TELEMETRY_TASK_PRIORITY, NULL);
+    ESP_LOGI(TAG, "PMU 0x%02x sampled every %d ms, %d samples per window",
+             address, CONFIG_LILYGO_PMU_TELEMETRY_PERIOD_MS, TELEMETRY_DECIMATION);
+    return true;
+}
+
+bool power_telemetry_latest(power_sample_t *sample)
+{
+    portENTER_CRITICAL(&telemetry_lock);
+    bool valid = has_latest;
+    *sample = latest;
+    portEXIT_CRITICAL(&telemetry_lock);
+    return valid;
+}
+
+uint32_t power_telemetry_windows(power_window_t *out, uint32_t max)
+{
+    portENTER_CRITICAL(&telemetry_lock);
+    uint32_t count = windows_head < TELEMETRY_WINDOWS ? windows_head : TELEMETRY_WINDOWS;
+    if (count > max) {
+        count = max;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = windows[(windows_head - count + i) % TELEMETRY_WINDOWS];
+    }
+    portEXIT_CRITICAL(&telemetry_lock);
+    return count;
+}
+
+uint32_t power_telemetry_errors(void)
+{
+    return errors;
+}
+
+#elif CONFIG_LILYGO_PMU_TELEMETRY
+
+// The board has no PMU whose registers are decoded here
+bool power_telemetry_start(void)
+{
+    return false;
+}
+
+bool power_telemetry_latest(power_sample_t *sample)
+{
+    return false;
+}
+
+uint32_t power_telemetry_windows(power_window_t *windows, uint32_t max)
+{
+    return 0;
+}
+
+uint32_t power_telemetry_errors(void)
+{
+    return 0;
+}
+#endif
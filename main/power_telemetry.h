@@ -0,0 +1,88 @@
+/**
+ * @file      power_telemetry.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <sdkconfig.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Temperature of a PMU without a die sensor, e.g. the SY6970
+#define POWER_TEMP_UNKNOWN      INT16_MIN
+
+typedef enum {
+    POWER_CHARGE_NONE,          // not charging
+    POWER_CHARGE_PRE,           // trickle or pre-charge
+    POWER_CHARGE_CC,            // constant current, fast charge
+    POWER_CHARGE_CV,            // constant voltage
+    POWER_CHARGE_DONE,
+} power_charge_t;
+
+typedef struct {
+    int64_t time_us;
+    uint16_t batt_mv;           // 0 without a battery
+    uint16_t vbus_mv;           // 0 without USB power
+    int16_t temp_dc;            // PMU die, 0.1 degC, or POWER_TEMP_UNKNOWN
+    bool batt_present;
+    bool vbus_good;
+    power_charge_t charge;
+} power_sample_t;
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t avg;
+} power_stat_t;
+
+// CONFIG_LILYGO_PMU_TELEMETRY_DECIMATION samples folded into one entry
+typedef struct {
+    int64_t time_us;            // last sample of the window
+    uint16_t samples;
+    power_stat_t batt_mv;
+    power_stat_t vbus_mv;
+    power_stat_t temp_dc;       // all POWER_TEMP_UNKNOWN without a sensor
+    power_charge_t charge;      // at the end of the window
+} power_window_t;
+
+#if CONFIG_LILYGO_PMU_TELEMETRY
+/**
+ * @brief Sample the PMU every CONFIG_LILYGO_PMU_TELEMETRY_PERIOD_MS
+ *
+ * Every sample takes one or two burst reads at PMU priority on the I2C
+ * scheduler. Nothing is logged per read, failed reads are only counted.
+ *
+ * @return false when no supported PMU answered during discovery
+ */
+bool power_telemetry_start(void);
+
+// Most recent sample, false before the first one
+bool power_telemetry_latest(power_sample_t *sample);
+
+/**
+ * @brief Copy the stored windows, oldest first
+ *
+ * @return Number of windows copied, at most max
+ */
+uint32_t power_telemetry_windows(power_window_t *windows, uint32_t max);
+
+// Reads that failed on the bus or missed their deadline
+uint32_t power_telemetry_errors(void);
+#else
+static inline bool power_telemetry_start(void)
+{
+    return false;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
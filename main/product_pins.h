@@ -45,7 +45,6 @@
 
 
 #define AMOLED_INIT_CMD     sh8501_cmd
-#define AMOLED_INIT_CMD_LEN SH8501_INIT_SEQUENCE_LENGHT
 
 #define CONFIG_PMU_AXP2101  (1)
 #define BOARD_HAS_TOUCH      1
@@ -78,7 +77,6 @@
 #define AMOLED_EN_PIN       (-1)
 
 #define AMOLED_INIT_CMD     rm67162_cmd
-#define AMOLED_INIT_CMD_LEN RM67162_INIT_SEQUENCE_LENGHT
 #define BOARD_HAS_TOUCH      0
 #define DISPLAY_BUFFER_SIZE  (AMOLED_WIDTH * AMOLED_HEIGHT)
 #define DISPLAY_FULLRESH     true
@@ -112,7 +110,6 @@
 #define AMOLED_EN_PIN       (38)
 
 #define AMOLED_INIT_CMD     rm67162_cmd
-#define AMOLED_INIT_CMD_LEN RM67162_INIT_SEQUENCE_LENGHT
 #define BOARD_HAS_TOUCH      1
 
 #define DISPLAY_BUFFER_SIZE  (AMOLED_WIDTH * AMOLED_HEIGHT)
@@ -151,7 +148,6 @@
 #define AMOLED_EN_PIN       (9)
 
 #define AMOLED_INIT_CMD     rm690b0_cmd
-#define AMOLED_INIT_CMD_LEN RM690B0_INIT_SEQUENCE_LENGHT
 
 #define CONFIG_PMU_SY6970   (1)
 
@@ -169,7 +165,6 @@
 #define AMOLED_EN_PIN       (-1)
 
 #define AMOLED_INIT_CMD     jd9613_cmd
-#define AMOLED_INIT_CMD_LEN JD9613_INIT_SEQUENCE_LENGHT
 
 #define BOARD_HAS_TOUCH      0
 #define DISPLAY_BUFFER_SIZE  (AMOLED_WIDTH * AMOLED_HEIGHT)
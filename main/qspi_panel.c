@@ -0,0 +1,216 @@
+/**
+ * @file      qspi_panel.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <sdkconfig.h>
+#include <assert.h>
+#include <string.h>
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_memory_utils.h"
+#include "qspi_panel.h"
+
+#define QSPI_CMD_WRITE              (0x02)
+#define QSPI_CMD_WRITE_QUAD         (0x32)
+#define QSPI_ADDR_RAMWR             (0x002C00)
+#define QSPI_ADDR_RAMWRC            (0x003C00)
+
+#if CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER
+// The SPI driver bounces buffers which are not DMA capable (PSRAM) through a
+// temporary internal copy per transaction, so keep only a few of them queued
+#define QSPI_BOUNCE_QUEUE_SIZE      (2)
+// What the SPI callbacks do around a queued transaction
+#define TRANS_CS_BEGIN              (1 << 0)    // pull CS low before the transaction
+#define TRANS_CS_END                (1 << 1)    // release CS afterwards
+#define TRANS_FLUSH_DONE            (1 << 2)    // last chunk of a push
+
+// Run in the SPI ISR. Polled transactions pass through here too, their user
+// field is NULL.
+static void IRAM_ATTR qspi_panel_pre_cb(spi_transaction_t *t)
+{
+    const qspi_panel_trans_t *trans = (const qspi_panel_trans_t *)t->user;
+    if (trans && (trans->flags & TRANS_CS_BEGIN)) {
+        gpio_set_level(trans->config->cs_gpio, 0);
+    }
+}
+
+static void IRAM_ATTR qspi_panel_post_cb(spi_transaction_t *t)
+{
+    const qspi_panel_trans_t *trans = (const qspi_panel_trans_t *)t->user;
+    if (!trans) {
+        return;
+    }
+    if (trans->flags & TRANS_CS_END) {
+        gpio_set_level(trans->config->cs_gpio, 1);
+    }
+    if ((trans->flags & TRANS_FLUSH_DONE) && trans->config->flush_done) {
+        trans->config->flush_done();
+    }
+}
+
+void qspi_panel_wait(qspi_panel_t *panel, uint32_t max_inflight)
+{
+    spi_transaction_t *rtrans;
+    while (panel->inflight > max_inflight) {
+        ESP_ERROR_CHECK(spi_device_get_trans_result(panel->spi, &rtrans, portMAX_DELAY));
+        panel->inflight--;
+    }
+}
+
+static qspi_panel_trans_t *qspi_panel_next_trans(qspi_panel_t *panel, uint32_t max_inflight)
+{
+    // Transactions complete in order, so the oldest pool entry is free again
+    // as soon as its result has been collected
+    qspi_panel_wait(panel, max_inflight - 1);
+    qspi_panel_trans_t *trans = &panel->pool[panel->head];
+    panel->head = (panel->head + 1) % QSPI_PANEL_QUEUE_SIZE;
+    memset(&trans->ext, 0, sizeof(trans->ext));
+    trans->config = &panel->config;
+    trans->ext.base.user = trans;
+    return trans;
+}
+
+static void qspi_panel_queue(qspi_panel_t *panel, qspi_panel_trans_t *trans, uint32_t flags)
+{
+    trans->flags = flags;
+    ESP_ERROR_CHECK(spi_device_queue_trans(panel->spi, &trans->ext.base, portMAX_DELAY));
+    panel->inflight++;
+}
+#else
+void qspi_panel_wait(qspi_panel_t *panel, uint32_t max_inflight)
+{
+}
+#endif
+
+esp_err_t qspi_panel_add_device(qspi_panel_t *panel, spi_host_device_t host, int clock_hz,
+                                const qspi_panel_config_t *config)
+{
+    memset(panel, 0, sizeof(*panel));
+    panel->config = *config;
+
+    spi_device_interface_config_t devcfg = {
+        .command_bits = 8,
+        .address_bits = 24,
+        .mode = 0,
+        .clock_speed_hz = clock_hz,
+        .spics_io_num = -1,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+        .queue_size = QSPI_PANEL_QUEUE_SIZE,
+#if CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER
+        .pre_cb = qspi_panel_pre_cb,
+        .post_cb = qspi_panel_post_cb,
+#endif
+    };
+    return spi_bus_add_device(host, &devcfg, &panel->spi);
+}
+
+void qspi_panel_write_cmd(qspi_panel_t *panel, uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    // Commands are polled, pixel data still in flight has to go out first
+    qspi_panel_wait(panel, 0);
+    gpio_set_level(panel->config.cs_gpio, 0);
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.flags = (SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR);
+    t.cmd = QSPI_CMD_WRITE;
+    t.addr = addr;
+    if (len != 0) {
+        t.tx_buffer = data;
+        t.length = 8 * len;
+    }
+    spi_device_polling_transmit(panel->spi, &t);
+    gpio_set_level(panel->config.cs_gpio, 1);
+}
+
+#if CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER
+void qspi_panel_queue_cmd(qspi_panel_t *panel, uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    qspi_panel_trans_t *trans;
+    if (len <= 4) {
+        trans = qspi_panel_next_trans(panel, QSPI_PANEL_QUEUE_SIZE);
+        trans->ext.base.flags = SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR | SPI_TRANS_USE_TXDATA;
+        memcpy(trans->ext.base.tx_data, data, len);
+    } else {
+        trans = qspi_panel_next_trans(panel, esp_ptr_dma_capable(data) ? QSPI_PANEL_QUEUE_SIZE : QSPI_BOUNCE_QUEUE_SIZE);
+        trans->ext.base.flags = SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR;
+        trans->ext.base.tx_buffer = data;
+    }
+    trans->ext.base.cmd = QSPI_CMD_WRITE;
+    trans->ext.base.addr = addr;
+    trans->ext.base.length = 8 * len;
+    qspi_panel_queue(panel, trans, TRANS_CS_BEGIN | TRANS_CS_END);
+}
+#else
+void qspi_panel_queue_cmd(qspi_panel_t *panel, uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    qspi_panel_write_cmd(panel, addr, data, len);
+}
+#endif
+
+void qspi_panel_send_chunk(qspi_panel_t *panel, uint16_t *p, size_t pixels, bool first, bool last)
+{
+    bool continue_cmd = panel->config.continue_cmd;
+#if CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER
+    qspi_panel_trans_t *trans = qspi_panel_next_trans(panel, esp_ptr_dma_capable(p) ? QSPI_PANEL_QUEUE_SIZE : QSPI_BOUNCE_QUEUE_SIZE);
+    spi_transaction_ext_t *t = &trans->ext;
+#else
+    spi_transaction_ext_t trans;
+    spi_transaction_ext_t *t = &trans;
+    memset(t, 0, sizeof(*t));
+#endif
+    if (first || continue_cmd) {
+        t->base.flags = SPI_TRANS_MODE_QIO;
+        t->base.cmd = QSPI_CMD_WRITE_QUAD;
+        t->base.addr = first ? QSPI_ADDR_RAMWR : QSPI_ADDR_RAMWRC;
+    } else {
+        // CS is still low, the controller keeps writing where the last chunk
+        // ended
+        t->base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
+        t->command_bits = 0;
+        t->address_bits = 0;
+        t->dummy_bits = 0;
+    }
+    t->base.tx_buffer = p;
+    t->base.length = pixels * 16;
+
+    bool cs_begin = first || continue_cmd;
+    bool cs_end = last || continue_cmd;
+#if CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER
+    qspi_panel_queue(panel, trans, (cs_begin ? TRANS_CS_BEGIN : 0) |
+                     (cs_end ? TRANS_CS_END : 0) | (last ? TRANS_FLUSH_DONE : 0));
+#else
+    if (cs_begin) {
+        gpio_set_level(panel->config.cs_gpio, 0);
+    }
+    spi_device_polling_transmit(panel->spi, &t->base);
+    if (cs_end) {
+        gpio_set_level(panel->config.cs_gpio, 1);
+    }
+    if (last && panel->config.flush_done) {
+        panel->config.flush_done();
+    }
+#endif
+}
+
+void qspi_panel_push(qspi_panel_t *panel, uint16_t *data, uint32_t len)
+{
+    bool first = true;
+    uint16_t *p = data;
+    assert(p);
+    assert(panel->spi);
+    do {
+        size_t chunk = len;
+        if (chunk > panel->config.chunk_pixels) {
+            chunk = panel->config.chunk_pixels;
+        }
+        len -= chunk;
+        qspi_panel_send_chunk(panel, p, chunk, first, len == 0);
+        first = false;
+        p += chunk;
+    } while (len > 0);
+}
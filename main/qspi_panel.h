@@ -0,0 +1,84 @@
+/**
+ * @file      qspi_panel.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <sdkconfig.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <driver/spi_master.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QSPI_PANEL_QUEUE_SIZE       (17)
+
+typedef struct {
+    int cs_gpio;                    // CS is a plain GPIO driven by this module
+    size_t chunk_pixels;            // pixels per transaction
+    // Send every chunk in its own CS frame, the ones after the first with
+    // RAMWRC (0x3C). Otherwise CS stays low from the first chunk to the
+    // last and only the first one carries a command.
+    bool continue_cmd;
+    // Called once the last chunk of a push is out, from the SPI ISR when
+    // transfers are queued, so it has to be in IRAM
+    void (*flush_done)(void);
+} qspi_panel_config_t;
+
+typedef struct qspi_panel_trans qspi_panel_trans_t;
+
+/*
+ * Command and pixel transfers to a QSPI panel controller (RM67162, SH8501,
+ * RM690B0, AXS15231B). With CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER the pixel
+ * chunks of a push are queued as DMA transactions and qspi_panel_push()
+ * returns before they are sent, otherwise every transfer is polled.
+ */
+typedef struct {
+    qspi_panel_config_t config;
+    spi_device_handle_t spi;
+#if CONFIG_LILYGO_AMOLED_QUEUED_TRANSFER
+    struct qspi_panel_trans {
+        spi_transaction_ext_t ext;  // first, the SPI driver only sees this
+        uint32_t flags;
+        const qspi_panel_config_t *config;
+    } pool[QSPI_PANEL_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t inflight;
+#endif
+} qspi_panel_t;
+
+/**
+ * @brief Add the panel to an initialized QSPI bus
+ *
+ * 8 command bits (0x02 write, 0x32 quad write) and 24 address bits, which
+ * carry the controller command as 0x00CC00.
+ */
+esp_err_t qspi_panel_add_device(qspi_panel_t *panel, spi_host_device_t host, int clock_hz,
+                                const qspi_panel_config_t *config);
+
+// Send a command with parameters now, after whatever is still queued
+void qspi_panel_write_cmd(qspi_panel_t *panel, uint32_t addr, const uint8_t *data, uint32_t len);
+
+// Queue a command behind whatever is in flight. Up to 4 parameter bytes are
+// copied, longer parameters have to stay valid until the command is done.
+void qspi_panel_queue_cmd(qspi_panel_t *panel, uint32_t addr, const uint8_t *data, uint32_t len);
+
+// Collect finished transactions until at most max_inflight are left queued
+void qspi_panel_wait(qspi_panel_t *panel, uint32_t max_inflight);
+
+// One transaction of a push, first starts the RAMWR, last ends the flush
+void qspi_panel_send_chunk(qspi_panel_t *panel, uint16_t *p, size_t pixels, bool first, bool last);
+
+// Send len pixels into the current window in chunk_pixels pieces
+void qspi_panel_push(qspi_panel_t *panel, uint16_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
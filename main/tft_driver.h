@@ -18,6 +18,7 @@ extern "C" {
 #endif
 
 void display_init();
+// Defined in panel_flush.cpp
 void display_push_colors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data);
 #ifdef __cplusplus
 }
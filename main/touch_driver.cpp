@@ -10,29 +10,42 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "i2c_driver.h"
+#include "i2c_sched.h"
 #include "product_pins.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "touch_driver.h"
+#include "touch_filter.h"
 
 #if BOARD_HAS_TOUCH
 
 static const char *TAG = "touch";
 
+// Per controller filter tuning, see touch_filter_config_t:
+// min cutoff (Hz), beta, speed cutoff (Hz), alpha, gain beta
 #if defined(CONFIG_LILYGO_T_AMOLED_LITE_147)
 #include "TouchDrvCHSC5816.hpp"
 TouchDrvCHSC5816 touch;
 #define TOUCH_ADDRESS   CHSC5816_SLAVE_ADDRESS
+#define TOUCH_FILTER_TUNING     1.0f, 0.05f, 5.0f, 0.5f, 0.1f
 
 #elif defined(CONFIG_LILYGO_T_DISPLAY_S3_AMOLED_TOUCH) || defined(CONFIG_LILYGO_T_DISPLAY_S3) || defined(CONFIG_LILYGO_T_QT_C6)
 #include "REG/CSTxxxConstants.h"
 #include "touch/TouchClassCST816.h"
 TouchClassCST816 touch;
 #define TOUCH_ADDRESS   CST816_SLAVE_ADDRESS
+// Coarse reports, smooth harder at rest
+#define TOUCH_FILTER_TUNING     0.8f, 0.05f, 5.0f, 0.4f, 0.08f
 
 #elif defined(CONFIG_LILYGO_T4_S3_241) || defined(CONFIG_LILYGO_T_DISPLAY_S3_PRO)
 #include "REG/CSTxxxConstants.h"
 #include "touch/TouchClassCST226.h"
 TouchClassCST226 touch;
 #define TOUCH_ADDRESS   CST226SE_SLAVE_ADDRESS
+#define TOUCH_FILTER_TUNING     1.5f, 0.05f, 5.0f, 0.5f, 0.1f
 
 #elif defined(CONFIG_LILYGO_T_DISPLAY_LONG)
 
@@ -45,12 +58,15 @@ TouchClassCST226 touch;
 #define AXS_GET_POINT_EVENT(buf,point_index) (buf[6*point_index+2] >> 6)
 #define TOUCH_ADDRESS               0x3B
 i2c_master_dev_handle_t             i2c_device;
+#define TOUCH_FILTER_TUNING     1.0f, 0.05f, 5.0f, 0.5f, 0.1f
 
 #elif defined(CONFIG_LILYGO_T_HMI)
 extern "C" {
     void board_hmi_touch_init();
     uint8_t board_hmi_get_point(uint16_t *x, uint16_t *y);
 }
+// XPT2046 resistive panel, by far the noisiest
+#define TOUCH_FILTER_TUNING     0.5f, 0.02f, 3.0f, 0.3f, 0.05f
 
 
 #elif defined(CONFIG_LILYGO_T_RGB)
@@ -59,11 +75,79 @@ extern "C" {
     void board_rgb_touch_init();
     uint8_t board_rgb_get_point(uint16_t *x, uint16_t *y);
 }
+// CST820, FT3267 or GT911, whichever answers
+#define TOUCH_FILTER_TUNING     1.0f, 0.05f, 5.0f, 0.5f, 0.1f
 
 #endif
 
 static bool _init_success = false;
 
+// Touch goes first on the bus, a read that cannot start within this is
+// stale anyway
+#define TOUCH_I2C_DEADLINE_MS   (20)
+
+#if !defined(CONFIG_LILYGO_T_DISPLAY_LONG) && !defined(CONFIG_LILYGO_T_HMI)
+typedef struct {
+    int16_t *x;
+    int16_t *y;
+    uint8_t point_num;
+    uint8_t touched;
+} touch_read_t;
+
+// The touch libraries access the bus themselves, run them in the I2C
+// scheduler task
+static esp_err_t touch_read_scheduled(void *arg)
+{
+    touch_read_t *read = (touch_read_t *)arg;
+#if defined(CONFIG_LILYGO_T_RGB)
+    uint16_t pointX;
+    uint16_t pointY;
+    read->touched = board_rgb_get_point(&pointX, &pointY);
+    if (read->touched) {
+        *read->x = pointX;
+        *read->y = pointY;
+    }
+#else
+    read->touched = touch.getPoint(read->x, read->y, read->point_num);
+#endif
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_LILYGO_TOUCH_IRQ_TASK
+#define TOUCH_TASK_PRIORITY     (3)
+#define TOUCH_TASK_STACK_SIZE   (4 * 1024)
+#define TOUCH_RING_SIZE         (CONFIG_LILYGO_TOUCH_RING_SIZE)
+
+// head and tail run freely, the ring index is taken modulo its size
+static touch_point_t ring[TOUCH_RING_SIZE];
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+static uint32_t ring_dropped = 0;
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t touch_task_handle = NULL;
+static void (*touch_notify)(void) = NULL;
+
+static touch_filter_t filter;
+#if CONFIG_LILYGO_TOUCH_FILTER_ONE_EURO || CONFIG_LILYGO_TOUCH_FILTER_ALPHA_BETA
+// Extrapolate at most this far, a flick must not throw the point off
+#define TOUCH_PREDICT_MAX_PX    (48)
+
+static const touch_filter_config_t filter_config = {
+#if CONFIG_LILYGO_TOUCH_FILTER_ONE_EURO
+    TOUCH_FILTER_ONE_EURO,
+#else
+    TOUCH_FILTER_ALPHA_BETA,
+#endif
+    TOUCH_FILTER_TUNING,
+    CONFIG_LILYGO_TOUCH_PREDICT_MS,
+    TOUCH_PREDICT_MAX_PX,
+};
+#else
+static const touch_filter_config_t filter_config = {.type = TOUCH_FILTER_NONE};
+#endif
+#endif
+
 
 void touch_home_button_callback(void *args)
 {
@@ -129,9 +213,9 @@ bool touch_init()
     return true;
 }
 
-uint8_t touch_get_data(int16_t *x, int16_t *y, uint8_t point_num)
+int touch_get_data(int16_t *x, int16_t *y, uint8_t point_num)
 {
-    uint8_t touched = 0;
+    int touched = 0;
 
 #if defined(CONFIG_LILYGO_T_DISPLAY_LONG)
     uint16_t pointX;
@@ -141,14 +225,15 @@ uint8_t touch_get_data(int16_t *x, int16_t *y, uint8_t point_num)
     uint8_t cmd[11] = {0xb5, 0xab, 0xa5, 0x5a, 0x0, 0x0, 0x0, 0x8};
     uint8_t buffer[20] = {0};
 
-    if (ESP_OK != i2c_master_transmit_receive(
+    if (ESP_OK != i2c_sched_transfer(
                 i2c_device,
+                I2C_SCHED_PRIO_TOUCH,
                 cmd,
                 sizeof(cmd) / sizeof(*cmd),
                 buffer,
                 20,
-                -1)) {
-        return 0 ;
+                TOUCH_I2C_DEADLINE_MS)) {
+        return -1;
     }
 
     type = AXS_GET_GESTURE_TYPE(buffer);
@@ -173,18 +258,20 @@ uint8_t touch_get_data(int16_t *x, int16_t *y, uint8_t point_num)
 
     }
 #elif defined(CONFIG_LILYGO_T_RGB)
-    uint16_t pointX;
-    uint16_t pointY;
-    touched = board_rgb_get_point(&pointX, &pointY);
-    if (touched) {
-        *x = pointX;
-        *y = pointY;
-
+    touch_read_t read = {x, y, point_num, 0};
+    if (i2c_sched_run(I2C_SCHED_PRIO_TOUCH, touch_read_scheduled, &read, TOUCH_I2C_DEADLINE_MS) != ESP_OK) {
+        return -1;
     }
+    touched = read.touched;
 #else
 
     if (!_init_success)return 0;
-    touched =  touch.getPoint(x, y, point_num);
+    touch_read_t read = {x, y, point_num, 0};
+    // Expired or failed in the scheduler, the controller was not read
+    if (i2c_sched_run(I2C_SCHED_PRIO_TOUCH, touch_read_scheduled, &read, TOUCH_I2C_DEADLINE_MS) != ESP_OK) {
+        return -1;
+    }
+    touched = read.touched;
     if (touched) {
         ESP_LOGI(TAG, "X:%d Y:%d touched:%d\n", *x, *y, touched);
     }
@@ -192,6 +279,147 @@ uint8_t touch_get_data(int16_t *x, int16_t *y, uint8_t point_num)
 #endif
     return touched;
 }
+
+#if CONFIG_LILYGO_TOUCH_IRQ_TASK
+static void IRAM_ATTR touch_isr(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(touch_task_handle, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// A full ring drops its oldest sample, the newest position and the release
+// matter more to LVGL
+static void touch_ring_push(const touch_point_t *point)
+{
+    portENTER_CRITICAL(&ring_lock);
+    if (ring_head - ring_tail == TOUCH_RING_SIZE) {
+        ring_tail++;
+        ring_dropped++;
+    }
+    ring[ring_head % TOUCH_RING_SIZE] = *point;
+    ring_head++;
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+bool touch_read_point(touch_point_t *point)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&ring_lock);
+    if (ring_tail != ring_head) {
+        *point = ring[ring_tail % TOUCH_RING_SIZE];
+        ring_tail++;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&ring_lock);
+    return ok;
+}
+
+uint32_t touch_points_pending()
+{
+    portENTER_CRITICAL(&ring_lock);
+    uint32_t pending = ring_head - ring_tail;
+    portEXIT_CRITICAL(&ring_lock);
+    return pending;
+}
+
+uint32_t touch_points_dropped()
+{
+    return ring_dropped;
+}
+
+#if CONFIG_LILYGO_LATENCY_TRACE_INJECT
+void touch_inject_point(int16_t x, int16_t y, bool pressed)
+{
+    touch_point_t point = {};
+    point.x = x;
+    point.y = y;
+    point.pressed = pressed;
+    point.time_us = esp_timer_get_time();
+    touch_ring_push(&point);
+    if (touch_notify) {
+        touch_notify();
+    }
+}
+#endif
+
+static void touch_task(void *arg)
+{
+    touch_point_t point = {};
+    while (1) {
+        // Nothing touches the bus until the controller signals a contact
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Follow the contact until it is released. Most controllers pulse
+        // the IRQ with every report while touched, the timeout covers the
+        // ones that only signal the first contact.
+        while (1) {
+            int16_t x, y;
+            int touched = touch_get_data(&x, &y, 1);
+            if (touched < 0) {
+                // No sample, a release here would end a drag the finger is
+                // still doing. Keep the state and try the next report.
+                if (!point.pressed) {
+                    break;
+                }
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_LILYGO_TOUCH_HOLD_POLL_MS));
+                continue;
+            }
+            bool pressed = touched > 0;
+            int64_t now = esp_timer_get_time();
+            if (!pressed && !point.pressed) {
+                break;
+            }
+            // A release keeps the last position, LVGL reports it there
+            if (pressed) {
+                touch_filter_update(&filter, &x, &y, now, AMOLED_HEIGHT - 1, AMOLED_WIDTH - 1);
+                point.x = x;
+                point.y = y;
+            }
+            point.pressed = pressed;
+            point.time_us = now;
+            touch_ring_push(&point);
+            if (touch_notify) {
+                touch_notify();
+            }
+            if (!pressed) {
+                touch_filter_reset(&filter);
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_LILYGO_TOUCH_HOLD_POLL_MS));
+        }
+    }
+}
+
+bool touch_start_task(void (*notify)(void))
+{
+    if (!_init_success) {
+        return false;
+    }
+    touch_notify = notify;
+    touch_filter_init(&filter, &filter_config);
+    xTaskCreate(touch_task, "touch", TOUCH_TASK_STACK_SIZE, NULL, TOUCH_TASK_PRIORITY, &touch_task_handle);
+    assert(touch_task_handle);
+
+    gpio_config_t irq_config = {};
+    irq_config.pin_bit_mask = 1ULL << BOARD_TOUCH_IRQ;
+    irq_config.mode = GPIO_MODE_INPUT;
+    irq_config.pull_up_en = GPIO_PULLUP_ENABLE;
+    irq_config.intr_type = GPIO_INTR_NEGEDGE;
+    ESP_ERROR_CHECK(gpio_config(&irq_config));
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "GPIO ISR service unavailable");
+        return false;
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add((gpio_num_t)BOARD_TOUCH_IRQ, touch_isr, NULL));
+    // A finger that is already down raises no new edge
+    xTaskNotifyGive(touch_task_handle);
+    ESP_LOGI(TAG, "Touch sampled on IRQ %d", (int)BOARD_TOUCH_IRQ);
+    return true;
+}
+#endif
 #else
 
 bool touch_init()
@@ -15,7 +15,46 @@
 #if defined(BOARD_HAS_TOUCH)
 
 bool touch_init();
-uint8_t touch_get_data(int16_t *x, int16_t *y, uint8_t point_num);
+
+// Number of points touched, negative when the controller could not be read.
+// A failed read says nothing about the contact, callers keep their state.
+int touch_get_data(int16_t *x, int16_t *y, uint8_t point_num);
+
+#if CONFIG_LILYGO_TOUCH_IRQ_TASK
+typedef struct {
+    int16_t x;
+    int16_t y;
+    bool pressed;               // false for the sample that ends a contact
+    int64_t time_us;            // esp_timer_get_time() when it was read
+} touch_point_t;
+
+/**
+ * @brief Read the controller from a task woken by BOARD_TOUCH_IRQ
+ *
+ * Samples go into a ring that touch_read_point() drains without any bus
+ * access. notify is called from the touch task after every sample.
+ *
+ * @return false when touch_init() failed, nothing is sampled then
+ */
+bool touch_start_task(void (*notify)(void));
+
+/**
+ * @brief Take the oldest sample from the ring
+ *
+ * @return false when the ring is empty
+ */
+bool touch_read_point(touch_point_t *point);
+
+uint32_t touch_points_pending();
+
+// Samples overwritten because the ring was full
+uint32_t touch_points_dropped();
+
+#if CONFIG_LILYGO_LATENCY_TRACE_INJECT
+// Push a synthetic sample taken now, as if the controller reported it
+void touch_inject_point(int16_t x, int16_t y, bool pressed);
+#endif
+#endif
 
 #else
 bool touch_init();
@@ -0,0 +1,100 @@
+/**
+ * @file      touch_filter.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#include <math.h>
+#include "touch_filter.h"
+
+// Samples further apart than this belong to a stalled contact, restart the
+// filter instead of integrating a huge step
+#define TOUCH_FILTER_MAX_DT     (0.2f)
+#define TOUCH_FILTER_MIN_DT     (0.001f)
+
+// Smoothing factor of a first order low pass with the given cutoff
+static inline float lowpass_alpha(float cutoff_hz, float dt)
+{
+    float tau = 1.0f / (2.0f * (float)M_PI * cutoff_hz);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+static void one_euro(const touch_filter_config_t *c, touch_filter_axis_t *a, float raw, float dt)
+{
+    float speed = (raw - a->raw) / dt;
+    a->raw = raw;
+    a->vel += lowpass_alpha(c->d_cutoff_hz, dt) * (speed - a->vel);
+    float cutoff = c->min_cutoff_hz + c->beta * fabsf(a->vel);
+    a->pos += lowpass_alpha(cutoff, dt) * (raw - a->pos);
+}
+
+static void alpha_beta(const touch_filter_config_t *c, touch_filter_axis_t *a, float raw, float dt)
+{
+    float predicted = a->pos + a->vel * dt;
+    float residual = raw - predicted;
+    a->pos = predicted + c->alpha * residual;
+    a->vel += c->gain_beta / dt * residual;
+}
+
+static int16_t predict(const touch_filter_config_t *c, const touch_filter_axis_t *a, int16_t max)
+{
+    float ahead = a->vel * c->predict_ms / 1000.0f;
+    if (ahead > c->max_predict_px) {
+        ahead = c->max_predict_px;
+    } else if (ahead < -c->max_predict_px) {
+        ahead = -c->max_predict_px;
+    }
+    float pos = roundf(a->pos + ahead);
+    if (pos < 0) {
+        return 0;
+    }
+    return pos > max ? max : (int16_t)pos;
+}
+
+void touch_filter_init(touch_filter_t *filter, const touch_filter_config_t *config)
+{
+    filter->config = *config;
+    touch_filter_reset(filter);
+}
+
+void touch_filter_reset(touch_filter_t *filter)
+{
+    filter->active = false;
+}
+
+void touch_filter_update(touch_filter_t *filter, int16_t *x, int16_t *y, int64_t time_us,
+                         int16_t max_x, int16_t max_y)
+{
+    const touch_filter_config_t *c = &filter->config;
+    if (c->type == TOUCH_FILTER_NONE) {
+        return;
+    }
+
+    float dt = (time_us - filter->last_us) / 1000000.0f;
+    filter->last_us = time_us;
+    if (!filter->active || dt > TOUCH_FILTER_MAX_DT) {
+        filter->x = (touch_filter_axis_t) {
+            .pos = *x, .vel = 0, .raw = *x
+        };
+        filter->y = (touch_filter_axis_t) {
+            .pos = *y, .vel = 0, .raw = *y
+        };
+        filter->active = true;
+        return;
+    }
+    if (dt < TOUCH_FILTER_MIN_DT) {
+        dt = TOUCH_FILTER_MIN_DT;
+    }
+
+    if (c->type == TOUCH_FILTER_ONE_EURO) {
+        one_euro(c, &filter->x, *x, dt);
+        one_euro(c, &filter->y, *y, dt);
+    } else {
+        alpha_beta(c, &filter->x, *x, dt);
+        alpha_beta(c, &filter->y, *y, dt);
+    }
+    *x = predict(c, &filter->x, max_x);
+    *y = predict(c, &filter->y, max_y);
+}
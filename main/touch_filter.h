@@ -0,0 +1,67 @@
+/**
+ * @file      touch_filter.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TOUCH_FILTER_NONE,
+    TOUCH_FILTER_ONE_EURO,      // adaptive low pass, smooth at rest, fast when moving
+    TOUCH_FILTER_ALPHA_BETA,    // constant gain position / velocity tracker
+} touch_filter_type_t;
+
+typedef struct {
+    touch_filter_type_t type;
+    float min_cutoff_hz;        // one euro: cutoff while the finger rests
+    float beta;                 // one euro: cutoff increase per px/s of speed
+    float d_cutoff_hz;          // one euro: cutoff of the speed estimate
+    float alpha;                // alpha-beta: position gain, 0 .. 1
+    float gain_beta;            // alpha-beta: velocity gain, 0 .. alpha
+    float predict_ms;           // extrapolate the position this far ahead
+    float max_predict_px;       // never extrapolate further than this
+} touch_filter_config_t;
+
+typedef struct {
+    float pos;                  // filtered position
+    float vel;                  // px/s
+    float raw;                  // last raw sample, one euro speed estimate
+} touch_filter_axis_t;
+
+typedef struct {
+    touch_filter_config_t config;
+    touch_filter_axis_t x;
+    touch_filter_axis_t y;
+    int64_t last_us;
+    bool active;                // false until the first sample of a contact
+} touch_filter_t;
+
+void touch_filter_init(touch_filter_t *filter, const touch_filter_config_t *config);
+
+/**
+ * @brief Forget the current contact, the next sample starts unfiltered
+ */
+void touch_filter_reset(touch_filter_t *filter);
+
+/**
+ * @brief Filter one sample of a contact in place
+ *
+ * x and y become the filtered position extrapolated by predict_ms along
+ * the filtered velocity, clamped to [0, max_x] and [0, max_y].
+ */
+void touch_filter_update(touch_filter_t *filter, int16_t *x, int16_t *y, int64_t time_us,
+                         int16_t max_x, int16_t max_y);
+
+#ifdef __cplusplus
+}
+#endif
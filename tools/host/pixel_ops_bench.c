@@ -0,0 +1,245 @@
+/**
+ * @file      pixel_ops_bench.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ * Host check of main/pixel_ops.c against the plain loops it replaced, and a
+ * timing of the T-AMOLED-Lite frame rotation. Nothing here needs ESP-IDF:
+ *
+ *   gcc -O2 -Wall -Imain tools/host/pixel_ops_bench.c main/pixel_ops.c -o pixel_ops_bench
+ *   ./pixel_ops_bench
+ *
+ * Exits non zero when a result differs. Host timings only show the relative
+ * gain of the access pattern, the ESP32-S3 numbers are different.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pixel_ops.h"
+
+// T-AMOLED-Lite: LVGL renders 368 x 194, the panel is mounted rotated
+#define LITE_WIDTH          (368)
+#define LITE_HEIGHT         (194)
+// Pixels per QSPI transaction, the stripe buffers are this big
+#define LITE_CHUNK_PIXELS   (16384)
+
+#define BENCH_FRAMES        (50)
+#define BENCH_ROUNDS        (40)
+
+static int failures = 0;
+
+// The rotation amoled_driver.c used before pixel_ops.c. Not inlined, the
+// firmware did not know the frame size at compile time either.
+__attribute__((noinline))
+static void rotate_old(uint16_t *pBuffer, const uint16_t *data, uint16_t width, uint16_t hight)
+{
+    const uint16_t *p = data;
+    uint32_t cum = 0;
+    for (uint16_t j = 0; j < width; j++) {
+        for (uint16_t i = 0; i < hight; i++) {
+            pBuffer[cum] = ((uint16_t)p[width * (hight - i - 1) + j]);
+            cum++;
+        }
+    }
+}
+
+static void swap16_ref(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = (uint16_t)((src[i] >> 8) | (src[i] << 8));
+    }
+}
+
+static void rgb666_ref(uint8_t *dst, const uint16_t *src, uint32_t count, bool swapped)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t p = swapped ? (uint16_t)((src[i] >> 8) | (src[i] << 8)) : src[i];
+        uint8_t r = p >> 11, g = (p >> 5) & 0x3F, b = p & 0x1F;
+        dst[3 * i + 0] = (r << 3) | (r >> 2);
+        dst[3 * i + 1] = (g << 2) | (g >> 4);
+        dst[3 * i + 2] = (b << 3) | (b >> 2);
+    }
+}
+
+static void fill_random(uint16_t *buf, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        buf[i] = (uint16_t)rand();
+    }
+}
+
+static void expect(bool ok, const char *what, unsigned a, unsigned b, unsigned c)
+{
+    if (!ok) {
+        printf("FAIL %s (%u, %u, %u)\n", what, a, b, c);
+        failures++;
+    }
+}
+
+// Whole image and every stripe of stripe_cols columns, src and dst shifted
+// by the given number of pixels to cover unaligned buffers
+static void check_rotate(uint16_t width, uint16_t height, uint16_t stripe_cols,
+                         unsigned src_shift, unsigned dst_shift)
+{
+    uint32_t count = (uint32_t)width * height;
+    uint16_t *src_buf = malloc((count + 2) * sizeof(uint16_t));
+    uint16_t *dst_buf = malloc((count + 2) * sizeof(uint16_t));
+    uint16_t *ref = malloc(count * sizeof(uint16_t));
+    uint16_t *src = src_buf + src_shift;
+    uint16_t *dst = dst_buf + dst_shift;
+
+    fill_random(src, count);
+    rotate_old(ref, src, width, height);
+
+    memset(dst, 0, count * sizeof(uint16_t));
+    pixel_rotate_cw(dst, src, width, height, 0, width);
+    expect(!memcmp(dst, ref, count * sizeof(uint16_t)), "rotate frame", width, height, src_shift);
+
+    for (uint16_t col = 0; col < width; col += stripe_cols) {
+        uint16_t cols = width - col < stripe_cols ? width - col : stripe_cols;
+        memset(dst, 0, count * sizeof(uint16_t));
+        pixel_rotate_cw(dst, src, width, height, col, cols);
+        expect(!memcmp(dst, ref + (uint32_t)col * height, (uint32_t)cols * height * sizeof(uint16_t)),
+               "rotate stripe", width, height, col);
+    }
+    free(src_buf);
+    free(dst_buf);
+    free(ref);
+}
+
+static void check_swap16(uint32_t count, unsigned src_shift, unsigned dst_shift)
+{
+    uint16_t *src_buf = calloc(count + 2, sizeof(uint16_t));
+    uint16_t *dst_buf = calloc(count + 2, sizeof(uint16_t));
+    uint16_t *ref = calloc(count + 1, sizeof(uint16_t));
+    uint16_t *src = src_buf + src_shift;
+    uint16_t *dst = dst_buf + dst_shift;
+
+    fill_random(src, count);
+    swap16_ref(ref, src, count);
+    pixel_swap16(dst, src, count);
+    expect(!memcmp(dst, ref, count * sizeof(uint16_t)), "swap16", count, src_shift, dst_shift);
+    // In place
+    pixel_swap16(src, src, count);
+    expect(!memcmp(src, ref, count * sizeof(uint16_t)), "swap16 in place", count, src_shift, 0);
+    free(src_buf);
+    free(dst_buf);
+    free(ref);
+}
+
+static void check_rgb666(uint32_t count, unsigned dst_shift, bool swapped)
+{
+    uint16_t *src = calloc(count + 1, sizeof(uint16_t));
+    uint8_t *dst_buf = calloc(count * 3 + 4, 1);
+    uint8_t *ref = calloc(count * 3 + 1, 1);
+    uint8_t *dst = dst_buf + dst_shift;
+
+    fill_random(src, count);
+    rgb666_ref(ref, src, count, swapped);
+    pixel_rgb565_to_rgb666(dst, src, count, swapped);
+    expect(!memcmp(dst, ref, count * 3), "rgb666", count, dst_shift, swapped);
+    free(src);
+    free(dst_buf);
+    free(ref);
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void rotate_frame(uint16_t *dst, const uint16_t *src, uint16_t stripe_cols)
+{
+    for (uint16_t col = 0; col < LITE_WIDTH; col += stripe_cols) {
+        uint16_t cols = LITE_WIDTH - col < stripe_cols ? LITE_WIDTH - col : stripe_cols;
+        pixel_rotate_cw(dst, src, LITE_WIDTH, LITE_HEIGHT, col, cols);
+    }
+}
+
+// Best of BENCH_ROUNDS rounds, the other processes on the host only ever
+// make a round slower
+static double bench_us(int variant, uint16_t *dst, const uint16_t *src, uint16_t stripe_cols)
+{
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double start = now_ms();
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            if (variant == 0) {
+                rotate_old(dst, src, LITE_WIDTH, LITE_HEIGHT);
+            } else {
+                rotate_frame(dst, src, variant == 1 ? LITE_WIDTH : stripe_cols);
+            }
+            __asm__ volatile("" : : "r"(dst) : "memory");
+        }
+        double us = (now_ms() - start) * 1000 / BENCH_FRAMES;
+        if (!round || us < best) {
+            best = us;
+        }
+    }
+    return best;
+}
+
+static void bench_rotate(void)
+{
+    uint32_t count = LITE_WIDTH * LITE_HEIGHT;
+    uint16_t *src = malloc(count * sizeof(uint16_t));
+    uint16_t *dst = malloc(count * sizeof(uint16_t));
+    // What the flush does: one stripe at a time into a chunk sized buffer
+    uint16_t stripe_cols = (LITE_CHUNK_PIXELS / LITE_HEIGHT) & ~1;
+    fill_random(src, count);
+
+    double old_us = bench_us(0, dst, src, stripe_cols);
+    double new_us = bench_us(1, dst, src, stripe_cols);
+    double stripe_us = bench_us(2, dst, src, stripe_cols);
+
+    printf("rotate %dx%d, best of %d x %d frames\n", LITE_WIDTH, LITE_HEIGHT, BENCH_ROUNDS, BENCH_FRAMES);
+    printf("  old loop          %8.1f us/frame\n", old_us);
+    printf("  pixel_rotate_cw   %8.1f us/frame  %.2fx\n", new_us, old_us / new_us);
+    printf("  %u column stripes %8.1f us/frame  %.2fx\n", stripe_cols, stripe_us, old_us / stripe_us);
+    free(src);
+    free(dst);
+}
+
+int main(void)
+{
+    srand(1);
+
+    // The Lite frame takes the 2x2 path, the others cover the scalar
+    // fallback: odd sizes, odd column ranges and unaligned buffers
+    check_rotate(LITE_WIDTH, LITE_HEIGHT, 84, 0, 0);
+    check_rotate(LITE_WIDTH, LITE_HEIGHT, 84, 1, 0);
+    check_rotate(LITE_WIDTH, LITE_HEIGHT, 84, 0, 1);
+    check_rotate(LITE_WIDTH, LITE_HEIGHT, 33, 0, 0);
+    check_rotate(37, 23, 5, 0, 0);
+    check_rotate(16, 16, 16, 0, 0);
+    check_rotate(2, 2, 2, 0, 0);
+    check_rotate(1, 1, 1, 0, 0);
+    check_rotate(64, 1, 8, 0, 0);
+    check_rotate(1, 64, 1, 0, 0);
+
+    for (uint32_t count = 0; count < 40; count++) {
+        for (unsigned s = 0; s < 2; s++) {
+            for (unsigned d = 0; d < 2; d++) {
+                check_swap16(count, s, d);
+            }
+            check_rgb666(count, s * 3, false);
+            check_rgb666(count, s * 3, true);
+        }
+    }
+    check_swap16(LITE_WIDTH * LITE_HEIGHT, 0, 0);
+    check_rgb666(LITE_WIDTH * LITE_HEIGHT, 0, true);
+
+    if (failures) {
+        printf("%d checks FAILED\n", failures);
+        return 1;
+    }
+    printf("pixel_ops matches the reference loops\n");
+    bench_rotate();
+    return 0;
+}
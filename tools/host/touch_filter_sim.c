@@ -0,0 +1,149 @@
+/**
+ * @file      touch_filter_sim.c
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2024  Shenzhen Xinyuan Electronic Technology Co., Ltd
+ * @date      2026-10-16
+ *
+ * Host simulation of main/touch_filter.c with the tunings of touch_driver.cpp.
+ * Nothing here needs ESP-IDF:
+ *
+ *   gcc -O2 -Wall -Imain tools/host/touch_filter_sim.c main/touch_filter.c -lm -o touch_filter_sim
+ *   ./touch_filter_sim
+ *
+ * A finger swipes at SWIPE_SPEED px/s and then rests, the controller reports
+ * it every SAMPLE_MS with up to +-NOISE_PX of noise. Printed per tuning:
+ * how far the reported point is from where the finger is PREDICT_MS later
+ * while moving, and how much it jitters at rest. Exits non zero when a filter
+ * does worse than the raw samples on either.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "touch_filter.h"
+
+#define SAMPLE_MS           (10)
+#define SWIPE_SPEED         (1000.0f)   // px/s
+#define SWIPE_SAMPLES       (50)        // 500 px
+#define SWIPE_SETTLE        (10)        // samples before the error counts
+#define REST_SAMPLES        (200)
+#define REST_SETTLE         (10)
+#define NOISE_PX            (2)
+#define PREDICT_MS          (20)        // CONFIG_LILYGO_TOUCH_PREDICT_MS default
+#define PREDICT_MAX_PX      (48)        // TOUCH_PREDICT_MAX_PX
+#define SCREEN_MAX          (1023)      // keeps the clamp out of the way
+#define RUNS                (100)
+
+typedef struct {
+    const char *name;
+    float min_cutoff_hz, beta, d_cutoff_hz, alpha, gain_beta;
+} tuning_t;
+
+// TOUCH_FILTER_TUNING of touch_driver.cpp
+static const tuning_t tunings[] = {
+    {"CHSC5816 / default", 1.0f, 0.05f, 5.0f, 0.5f, 0.1f},
+    {"CST816",             0.8f, 0.05f, 5.0f, 0.4f, 0.08f},
+    {"CST226",             1.5f, 0.05f, 5.0f, 0.5f, 0.1f},
+};
+
+typedef struct {
+    double swipe_err;       // mean |reported - finger PREDICT_MS later|, px
+    double swipe_max;
+    double rest_rms;        // RMS distance from the resting finger, px
+    double rest_pp;         // peak to peak at rest, px
+} result_t;
+
+static int16_t noisy(float pos)
+{
+    return (int16_t)lroundf(pos) + rand() % (2 * NOISE_PX + 1) - NOISE_PX;
+}
+
+static void run(touch_filter_type_t type, const tuning_t *t, result_t *r)
+{
+    touch_filter_config_t config = {
+        type, t->min_cutoff_hz, t->beta, t->d_cutoff_hz, t->alpha, t->gain_beta,
+        PREDICT_MS, PREDICT_MAX_PX,
+    };
+    touch_filter_t filter;
+    touch_filter_init(&filter, &config);
+
+    double err_sum = 0, rest_sum = 0, worst = 0, pp = 0;
+    int err_n = 0, rest_n = 0;
+    srand(1);
+
+    for (int run = 0; run < RUNS; run++) {
+        touch_filter_reset(&filter);
+        int64_t now = (int64_t)run * 1000000;
+        float start = 100;
+        float end = start + SWIPE_SPEED * SWIPE_SAMPLES * SAMPLE_MS / 1000;
+        int16_t rest_min = SCREEN_MAX, rest_max = 0;
+
+        for (int i = 0; i < SWIPE_SAMPLES + REST_SAMPLES; i++, now += SAMPLE_MS * 1000) {
+            bool moving = i < SWIPE_SAMPLES;
+            float finger = moving ? start + SWIPE_SPEED * i * SAMPLE_MS / 1000 : end;
+            int16_t x = noisy(finger), y = noisy(200);
+            if (type == TOUCH_FILTER_NONE) {
+                // What LVGL got before: the raw sample
+            } else {
+                touch_filter_update(&filter, &x, &y, now, SCREEN_MAX, SCREEN_MAX);
+            }
+
+            if (moving && i >= SWIPE_SETTLE && i + PREDICT_MS / SAMPLE_MS < SWIPE_SAMPLES) {
+                float target = finger + SWIPE_SPEED * PREDICT_MS / 1000;
+                double e = fabs(x - target);
+                err_sum += e;
+                err_n++;
+                worst = e > worst ? e : worst;
+            } else if (!moving && i >= SWIPE_SAMPLES + REST_SETTLE) {
+                double dx = x - end, dy = y - 200;
+                rest_sum += dx * dx + dy * dy;
+                rest_n++;
+                rest_min = x < rest_min ? x : rest_min;
+                rest_max = x > rest_max ? x : rest_max;
+            }
+        }
+        pp += rest_max - rest_min;
+    }
+    r->swipe_err = err_sum / err_n;
+    r->swipe_max = worst;
+    r->rest_rms = sqrt(rest_sum / rest_n);
+    r->rest_pp = pp / RUNS;
+}
+
+static void print(const char *filter, const char *tuning, const result_t *r)
+{
+    printf("  %-11s %-19s %5.1f px  %5.1f px  %5.2f px  %4.1f px\n",
+           filter, tuning, r->swipe_err, r->swipe_max, r->rest_rms, r->rest_pp);
+}
+
+int main(void)
+{
+    int failures = 0;
+    result_t raw;
+    run(TOUCH_FILTER_NONE, &tunings[0], &raw);
+
+    printf("%.0f px/s swipe, a sample every %d ms, +-%d px noise, %d runs\n",
+           SWIPE_SPEED, SAMPLE_MS, NOISE_PX, RUNS);
+    printf("  %-11s %-19s %8s  %8s  %8s  %7s\n", "filter", "tuning",
+           "err", "max err", "rest rms", "rest pp");
+    printf("  (err: against the finger %d ms later while moving)\n", PREDICT_MS);
+    print("none", "-", &raw);
+
+    for (unsigned i = 0; i < sizeof(tunings) / sizeof(tunings[0]); i++) {
+        result_t euro, ab;
+        run(TOUCH_FILTER_ONE_EURO, &tunings[i], &euro);
+        run(TOUCH_FILTER_ALPHA_BETA, &tunings[i], &ab);
+        print("one euro", tunings[i].name, &euro);
+        print("alpha-beta", tunings[i].name, &ab);
+
+        const result_t *r[] = {&euro, &ab};
+        for (int j = 0; j < 2; j++) {
+            if (r[j]->swipe_err >= raw.swipe_err || r[j]->rest_rms >= raw.rest_rms) {
+                printf("FAIL %s %s does worse than the raw samples\n",
+                       j ? "alpha-beta" : "one euro", tunings[i].name);
+                failures++;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}